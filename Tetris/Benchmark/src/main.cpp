@@ -0,0 +1,622 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "core/scenario.h"
+
+
+/*
+ * Microbenchmarks of the game rules. Every benchmark works on inputs built from fixed seeds,
+ * so two runs measure the same work. Results can be written as JSON and compared against a
+ * previous run, failing when an operation got slower than the threshold allows.
+ */
+
+struct Options
+{
+	std::string filter;
+	unsigned int samples = 15;
+	double minSampleTime = 0.02;
+	std::string output;
+	std::string baseline;
+	double threshold = 10.0;
+};
+
+/* Runs the operation of a sample iterations times and returns a value depending on every result */
+using BenchmarkRun = std::function<UInt64()>;
+
+struct Benchmark
+{
+	const char* name;
+	/* Builds the inputs of one sample, outside of the timed part */
+	std::function<BenchmarkRun(UInt64 iterations)> setup;
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	UInt64 iterations = 0;
+	double median = 0;
+	double min = 0;
+	double mean = 0;
+	double stddev = 0;
+	double baseline = 0;
+};
+
+
+static volatile UInt64 sink = 0;
+
+static constexpr UInt64 benchmark_seed = 0x5EED;
+static constexpr Size probe_count = 1024;
+
+struct Probe
+{
+	core::Tetromino::Type type;
+	core::RotationState rotation;
+	int row;
+	int column;
+};
+
+
+/* Drops a piece with its leftmost cell on column. False when it does not fit at the top */
+static bool drop_piece(core::Field& field, core::Tetromino::Type type, core::RotationState rotation, int column)
+{
+	core::Tetromino tetromino{ type };
+	tetromino.setRotationState(rotation);
+	tetromino.setPosition(core::Field::visible_rows - 2, column);
+
+	int left = std::numeric_limits<int>::max();
+	for (const auto& cell : tetromino.cellsAsVector())
+		left = std::min(left, cell.x);
+	tetromino.move(0, column - left);
+
+	if (!field.fits(tetromino))
+		return false;
+
+	tetromino.move(-field.dropDistance(tetromino), 0);
+	field.insert(tetromino);
+	return true;
+}
+
+static void drop_random_pieces(core::Field& field, core::Random& random, unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
+		drop_piece(field,
+			static_cast<core::Tetromino::Type>(random.below(core::Tetromino::type_count)),
+			core::RotationState{ static_cast<int>(random.below(4)) },
+			static_cast<int>(random.below(core::Field::columns - 1))
+		);
+}
+
+/* Stack of random pieces, the board of a game in progress */
+static core::Field make_garbage_field()
+{
+	core::Random random{ benchmark_seed };
+	core::Field field;
+	drop_random_pieces(field, random, 14);
+	return field;
+}
+
+/* Four complete rows under some random pieces, ready for a tetris */
+static core::Field make_tetris_field()
+{
+	core::Random random{ benchmark_seed };
+	core::Field field;
+	for (int column = 0; column < core::Field::columns; column++)
+		drop_piece(field, core::Tetromino::Type::I, core::RotationState::right(), column);
+	drop_random_pieces(field, random, 6);
+	return field;
+}
+
+static std::vector<Probe> make_probes(const core::Field& field, bool fitting)
+{
+	core::Random random{ benchmark_seed };
+	std::vector<Probe> probes;
+	while (probes.size() < probe_count)
+	{
+		const Probe probe = {
+			static_cast<core::Tetromino::Type>(random.below(core::Tetromino::type_count)),
+			core::RotationState{ static_cast<int>(random.below(4)) },
+			static_cast<int>(random.below(core::Field::visible_rows)),
+			static_cast<int>(random.below(core::Field::columns + 2)) - 1
+		};
+		if (!fitting || field.fits(probe.type, probe.rotation, probe.row, probe.column))
+			probes.push_back(probe);
+	}
+	return probes;
+}
+
+
+/*
+ * Player that rotates, moves and hard drops every piece from a fixed script. Inputs are only
+ * sent to a live piece, one every few ticks, so none of them is lost while a piece is inserted.
+ * The insertion delay passes in a single update, otherwise most ticks would have nothing to do.
+ * Each game starts the script over, so every game played from the same seed is the same.
+ */
+class ScriptedPlayer
+{
+public:
+	static constexpr int actions_per_piece = 6;
+	static constexpr UInt64 ticks_per_action = 4;
+	static constexpr Size script_pieces = 256;
+
+	/* Microseconds of the update that ends an insertion, longer than any insertion delay */
+	static constexpr Int64 insertion_step = 1000000;
+
+private:
+	std::vector<core::ScenarioAction> _script;
+	Size _piece;
+	UInt64 _spawn;
+	int _action;
+	UInt64 _wait;
+
+public:
+	explicit ScriptedPlayer(UInt64 seed) :
+		_script{},
+		_piece{ 0 },
+		_spawn{ 0 },
+		_action{ actions_per_piece },
+		_wait{ 0 }
+	{
+		core::Random random{ seed };
+		for (Size piece = 0; piece < script_pieces; piece++)
+		{
+			const auto rotate = static_cast<core::ScenarioAction>(static_cast<int>(core::ScenarioAction::RotateLeft) + random.below(3));
+			const auto move = random.below(2) ? core::ScenarioAction::MoveLeft : core::ScenarioAction::MoveRight;
+			const UInt32 moves = random.below(actions_per_piece - 1);
+			for (int action = 0; action < actions_per_piece - 1; action++)
+				_script.push_back(action == 0 ? rotate : static_cast<UInt32>(action) <= moves ? move : core::ScenarioAction::None);
+			_script.push_back(core::ScenarioAction::HardDrop);
+		}
+	}
+
+	inline void restart()
+	{
+		_piece = 0;
+		_spawn = 0;
+		_action = actions_per_piece;
+		_wait = 0;
+	}
+
+	/* Sends the input due, if any, and advances the scenario one tick */
+	inline void play(core::Scenario& scenario, const core::Time& tick)
+	{
+		if (scenario.tetrominoState() == core::Scenario::TetrominoState::Inserting)
+		{
+			scenario.update(core::Time{ insertion_step });
+			return;
+		}
+
+		if (scenario.hasCurrentTetromino())
+			_send(scenario);
+		scenario.update(tick);
+	}
+
+private:
+	inline void _send(core::Scenario& scenario)
+	{
+		if (scenario.spawnCount() != _spawn)
+		{
+			_spawn = scenario.spawnCount();
+			_piece = static_cast<Size>((_spawn - 1) % script_pieces);
+			_action = 0;
+			_wait = 0;
+		}
+
+		if (_action >= actions_per_piece)
+			return;
+
+		if (_wait > 0)
+			_wait--;
+		else
+		{
+			const core::ScenarioAction action = _script[(_piece * actions_per_piece) + static_cast<Size>(_action++)];
+			if (action != core::ScenarioAction::None)
+				scenario.pushAction(action);
+			_wait = ticks_per_action - 1;
+		}
+	}
+};
+
+/* Ticks the scripted player needs to top out a game. Every game takes the same */
+static UInt64 scripted_game_ticks(const core::Time& tick)
+{
+	static constexpr UInt64 max_ticks = 10000000;
+
+	core::Scenario scenario{ benchmark_seed };
+	ScriptedPlayer player{ benchmark_seed };
+	UInt64 ticks = 0;
+	for (; ticks < max_ticks && scenario.state() == core::Scenario::State::Running; ticks++)
+	{
+		player.play(scenario, tick);
+	}
+	return ticks;
+}
+
+
+static std::vector<Benchmark> make_benchmarks()
+{
+	std::vector<Benchmark> benchmarks;
+
+	benchmarks.push_back({ "field/collide", [](UInt64 iterations) -> BenchmarkRun {
+		const core::Field field = make_garbage_field();
+		return [iterations, field, probes = make_probes(field, false)]() {
+			UInt64 hits = 0;
+			for (UInt64 i = 0; i < iterations; i++)
+			{
+				const Probe& probe = probes[i % probe_count];
+				hits += field.collide(core::Tetromino::shape(probe.type, probe.rotation), probe.row, probe.column) ? 1 : 0;
+			}
+			return hits;
+		};
+	} });
+
+	/* Copy alone, to tell it apart from the erase benchmark that needs a fresh field every time */
+	benchmarks.push_back({ "field/copy", [](UInt64 iterations) -> BenchmarkRun {
+		return [iterations, base = make_tetris_field()]() {
+			UInt64 sum = 0;
+			for (UInt64 i = 0; i < iterations; i++)
+			{
+				core::Field field = base;
+				sum += field.rowMask(static_cast<int>(i % core::Field::rows));
+			}
+			return sum;
+		};
+	} });
+
+	benchmarks.push_back({ "field/erase_drop", [](UInt64 iterations) -> BenchmarkRun {
+		return [iterations, base = make_tetris_field()]() {
+			UInt64 sum = 0;
+			for (UInt64 i = 0; i < iterations; i++)
+			{
+				core::Field field = base;
+				for (int row = 3; row >= 0; row--)
+					field.eraseIfComplete(row);
+				field.dropRows(0);
+				sum += field.rowMask(0);
+			}
+			return sum;
+		};
+	} });
+
+	/* The rotation of Scenario: kick tries until the rotated shape fits */
+	benchmarks.push_back({ "tetromino/rotate_kick", [](UInt64 iterations) -> BenchmarkRun {
+		const core::Field field = make_garbage_field();
+		return [iterations, field, probes = make_probes(field, true)]() {
+			UInt64 kicks = 0;
+			for (UInt64 i = 0; i < iterations; i++)
+			{
+				const Probe& probe = probes[i % probe_count];
+				const core::RotationState to = probe.rotation + static_cast<int>(1 + (i & 1) * 2);
+				const auto& shape = core::Tetromino::shape(probe.type, to);
+				const auto& data = core::Tetromino::kicks(probe.type, probe.rotation, to);
+
+				int kick = 0;
+				while (kick < data.count && !field.fits(shape, probe.row + data.tries[kick].y, probe.column + data.tries[kick].x))
+					kick++;
+				kicks += static_cast<UInt64>(kick);
+			}
+			return kicks;
+		};
+	} });
+
+	benchmarks.push_back({ "tetromino/ghost", [](UInt64 iterations) -> BenchmarkRun {
+		const core::Field field = make_garbage_field();
+		return [iterations, field, probes = make_probes(field, true)]() {
+			UInt64 rows = 0;
+			for (UInt64 i = 0; i < iterations; i++)
+			{
+				const Probe& probe = probes[i % probe_count];
+				rows += static_cast<UInt64>(field.dropDistance(core::Tetromino::shape(probe.type, probe.rotation), probe.row, probe.column));
+			}
+			return rows;
+		};
+	} });
+
+	benchmarks.push_back({ "randomizer/bag_take", [](UInt64 iterations) -> BenchmarkRun {
+		return [iterations, bag = core::TetrominoBag{ benchmark_seed }]() mutable {
+			UInt64 sum = 0;
+			for (UInt64 i = 0; i < iterations; i++)
+				sum += static_cast<UInt64>(bag.take());
+			return sum;
+		};
+	} });
+
+	benchmarks.push_back({ "score/update", [](UInt64 iterations) -> BenchmarkRun {
+		return [iterations, score = core::Score{}]() mutable {
+			for (UInt64 i = 0; i < iterations; i++)
+			{
+				switch (i & 7)
+				{
+					case 0: score.addLines(1); score.addSingleScore(); break;
+					case 1: score.addLines(2); score.addDoubleScore(); break;
+					case 2: score.addLines(4); score.addTetrisScore(); break;
+					case 3: score.addLines(2); score.addTSpinDoubleScore(); break;
+					case 4: score.addTSpinMiniNoLinesScore(); break;
+					case 5: score.addLines(3); score.addTripleScore(); break;
+					case 6: score.addLines(1); score.addTSpinSingleScore(); break;
+					default: score.setLevel(static_cast<unsigned int>(1 + (i >> 3) % 15)); break;
+				}
+			}
+			return score.points() + score.lines();
+		};
+	} });
+
+	/*
+	 * Full ticks at 240 Hz, played by the scripted player. Every game is the same, so the games
+	 * a sample goes through are built in advance from the length of one of them.
+	 */
+	{
+		const core::Time tick{ 1000000 / 240 };
+		const UInt64 gameTicks = scripted_game_ticks(tick);
+
+		benchmarks.push_back({ "scenario/update", [tick, gameTicks](UInt64 iterations) -> BenchmarkRun {
+			std::vector<core::Scenario> games(static_cast<Size>(iterations / gameTicks + 1), core::Scenario{ benchmark_seed });
+
+			return [iterations, tick, games = std::move(games), player = ScriptedPlayer{ benchmark_seed }]() mutable {
+				core::Scenario* scenario = &games.front();
+				UInt64 pieces = 0;
+				for (UInt64 i = 0; i < iterations; i++)
+				{
+					if (scenario->state() != core::Scenario::State::Running)
+					{
+						pieces += scenario->spawnCount();
+						scenario++;
+						player.restart();
+					}
+
+					player.play(*scenario, tick);
+				}
+				return pieces + scenario->spawnCount();
+			};
+		} });
+	}
+
+	return benchmarks;
+}
+
+
+static double run_sample(const Benchmark& benchmark, UInt64 iterations)
+{
+	const BenchmarkRun run = benchmark.setup(iterations);
+
+	const auto start = std::chrono::steady_clock::now();
+	sink = sink + run();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchmarkResult run_benchmark(const Benchmark& benchmark, const Options& options)
+{
+	/* Grows the iterations until one sample takes the minimum time */
+	UInt64 iterations = 1;
+	for (double elapsed = run_sample(benchmark, iterations); elapsed < options.minSampleTime; elapsed = run_sample(benchmark, iterations))
+	{
+		const double scale = elapsed > 0 ? (options.minSampleTime * 1.2) / elapsed : 100.0;
+		iterations = std::max(iterations + 1, static_cast<UInt64>(static_cast<double>(iterations) * std::min(scale, 100.0)));
+	}
+
+	std::vector<double> samples;
+	for (unsigned int i = 0; i < options.samples; i++)
+		samples.push_back(run_sample(benchmark, iterations) * 1e9 / static_cast<double>(iterations));
+	std::sort(samples.begin(), samples.end());
+
+	BenchmarkResult result;
+	result.name = benchmark.name;
+	result.iterations = iterations;
+	result.median = samples[samples.size() / 2];
+	result.min = samples.front();
+	result.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+
+	double variance = 0;
+	for (double sample : samples)
+		variance += (sample - result.mean) * (sample - result.mean);
+	result.stddev = std::sqrt(variance / static_cast<double>(samples.size()));
+	return result;
+}
+
+
+static void print_usage()
+{
+	std::cout <<
+		"Usage: Benchmark [options]\n"
+		"  --filter TEXT    only benchmarks whose name contains TEXT\n"
+		"  --samples N      timed samples per benchmark, the median is reported (15)\n"
+		"  --min-time-ms N  minimum time of one sample (20)\n"
+		"  --json FILE      write the results as JSON\n"
+		"  --baseline FILE  compare the medians with a JSON file written by --json\n"
+		"  --threshold PCT  slowdown over the baseline that counts as a regression (10)\n"
+		"Exits with 2 when some benchmark regressed.\n";
+}
+
+/* Whole text as a number, without sign for the unsigned one. False for anything else */
+static bool parse_number(const std::string& text, unsigned int& value)
+{
+	Size parsed = 0;
+	unsigned long long number = 0;
+	try
+	{
+		number = std::stoull(text, &parsed);
+	}
+	catch (const std::invalid_argument&) { return false; }
+	catch (const std::out_of_range&) { return false; }
+
+	if (parsed != text.size() || text.front() == '-' || text.front() == '+' || number > std::numeric_limits<unsigned int>::max())
+		return false;
+
+	value = static_cast<unsigned int>(number);
+	return true;
+}
+
+static bool parse_number(const std::string& text, double& value)
+{
+	Size parsed = 0;
+	try
+	{
+		value = std::stod(text, &parsed);
+	}
+	catch (const std::invalid_argument&) { return false; }
+	catch (const std::out_of_range&) { return false; }
+
+	return parsed == text.size() && std::isfinite(value);
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h")
+			return false;
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << arg << std::endl;
+			return false;
+		}
+
+		const std::string value = argv[++i];
+		unsigned int count = 0;
+		double number = 0;
+		if (arg == "--filter") options.filter = value;
+		else if (arg == "--samples" && parse_number(value, count)) options.samples = std::max(1U, count);
+		else if (arg == "--min-time-ms" && parse_number(value, number)) options.minSampleTime = std::max(1.0, number) / 1000.0;
+		else if (arg == "--json") options.output = value;
+		else if (arg == "--baseline") options.baseline = value;
+		else if (arg == "--threshold" && parse_number(value, number)) options.threshold = number;
+		else if (arg == "--samples" || arg == "--min-time-ms" || arg == "--threshold")
+		{
+			std::cerr << "Invalid value " << value << " for " << arg << std::endl;
+			return false;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << arg << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool read_baseline(const std::string& filename, std::map<std::string, double>& medians)
+{
+	std::ifstream file{ filename };
+	if (!file)
+		return false;
+
+	try
+	{
+		const nlohmann::json json = nlohmann::json::parse(file);
+		for (const auto& benchmark : json.at("benchmarks"))
+			medians[benchmark.at("name").get<std::string>()] = benchmark.at("ns_per_op").at("median").get<double>();
+	}
+	catch (const nlohmann::json::exception& ex)
+	{
+		std::cerr << filename << ": " << ex.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool write_results(const std::string& filename, const std::vector<BenchmarkResult>& results, const Options& options)
+{
+	nlohmann::json json;
+	json["samples"] = options.samples;
+	json["min_sample_ms"] = options.minSampleTime * 1000.0;
+	json["benchmarks"] = nlohmann::json::array();
+
+	for (const auto& result : results)
+	{
+		nlohmann::json benchmark;
+		benchmark["name"] = result.name;
+		benchmark["iterations"] = result.iterations;
+		benchmark["ns_per_op"] = { { "median", result.median }, { "min", result.min }, { "mean", result.mean }, { "stddev", result.stddev } };
+		if (result.baseline > 0)
+			benchmark["baseline_median"] = result.baseline;
+		json["benchmarks"].push_back(benchmark);
+	}
+
+	std::ofstream file{ filename };
+	if (!file)
+		return false;
+
+	file << json.dump(2) << std::endl;
+	return static_cast<bool>(file);
+}
+
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parse_options(argc, argv, options))
+	{
+		print_usage();
+		return 1;
+	}
+
+	std::map<std::string, double> baseline;
+	if (!options.baseline.empty() && !read_baseline(options.baseline, baseline))
+	{
+		std::cerr << "Cannot read baseline " << options.baseline << std::endl;
+		return 1;
+	}
+
+	std::vector<BenchmarkResult> results;
+	unsigned int regressions = 0;
+
+	std::cout << std::left << std::setw(24) << "benchmark" << std::right
+		<< std::setw(14) << "median ns" << std::setw(12) << "min ns" << std::setw(12) << "stddev" << std::setw(14) << "iterations";
+	if (!baseline.empty())
+		std::cout << std::setw(14) << "baseline ns" << std::setw(10) << "change";
+	std::cout << std::endl;
+
+	for (const auto& benchmark : make_benchmarks())
+	{
+		if (!options.filter.empty() && std::string{ benchmark.name }.find(options.filter) == std::string::npos)
+			continue;
+
+		BenchmarkResult result = run_benchmark(benchmark, options);
+
+		std::cout << std::left << std::setw(24) << result.name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(14) << result.median << std::setw(12) << result.min << std::setw(12) << result.stddev << std::setw(14) << result.iterations;
+
+		const auto base = baseline.find(result.name);
+		if (base != baseline.end() && base->second > 0)
+		{
+			result.baseline = base->second;
+			const double change = (result.median / result.baseline - 1.0) * 100.0;
+			std::cout << std::setw(14) << result.baseline << std::setw(9) << std::showpos << change << "%" << std::noshowpos;
+			if (change > options.threshold)
+			{
+				std::cout << "  REGRESSION";
+				regressions++;
+			}
+		}
+		std::cout << std::endl;
+
+		results.push_back(result);
+	}
+
+	if (!options.output.empty() && !write_results(options.output, results, options))
+	{
+		std::cerr << "Cannot write " << options.output << std::endl;
+		return 1;
+	}
+
+	if (regressions > 0)
+	{
+		std::cout << regressions << " benchmark(s) over the " << options.threshold << "% threshold" << std::endl;
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+#include "core/bot.h"
+#include "core/beam_search.h"
+#include "core/trace.h"
+
+
+/*
+ * Headless self-play: runs N bot driven games through core::Scenario::update, spread over
+ * every core, and prints throughput and result distributions. With --scaling it instead
+ * measures the beam search speed from 1 to N threads on a position of the first game.
+ */
+
+struct Options
+{
+	unsigned int games = 100;
+	unsigned int threads = std::max(1U, std::thread::hardware_concurrency());
+	UInt64 seed = 1;
+	unsigned int maxPieces = 1000;
+	unsigned int level = 1;
+	core::Time tick = core::Time{ 16667 };
+	core::RandomizerType randomizer = core::RandomizerType::SevenBag;
+	std::string trace;
+	unsigned int scaling = 0;
+	core::BotSettings bot;
+};
+
+/* Beam search settings of --scaling when the options leave them at 0 */
+static constexpr unsigned int scaling_beam_width = 256;
+static constexpr unsigned int scaling_pieces = 40;
+static constexpr unsigned int scaling_repeats = 20;
+
+struct GameResult
+{
+	UInt64 seed = 0;
+	UInt64 pieces = 0;
+	UInt64 ticks = 0;
+	UInt64 lines = 0;
+	UInt64 points = 0;
+	bool toppedOut = false;
+};
+
+
+static void print_usage()
+{
+	std::cout <<
+		"Usage: SelfPlay [options]\n"
+		"  --games N        games to play (100)\n"
+		"  --threads N      games played at once (all cores)\n"
+		"  --seed N         seed of the first game, the rest use the following ones (1)\n"
+		"  --max-pieces N   pieces before a game is stopped (1000)\n"
+		"  --level N        starting level (1)\n"
+		"  --tick-us N      simulated microseconds per update (16667)\n"
+		"  --previews N     next pieces the bot looks ahead (0)\n"
+		"  --beam N         beam width of the bot search, 0 for exhaustive (0)\n"
+		"  --randomizer R   7-bag, 14-bag, 7+1, history-4 or random (7-bag)\n"
+		"  --trace FILE     Chrome trace of the recorded zones, in TETRIS_TRACE builds\n"
+		"  --scaling N      only measure the beam search nodes/s and efficiency on 1 to N threads,\n"
+		"                   with --beam (256 if 0) and --previews (5 if 0)\n";
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+	options.bot.previews = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h")
+			return false;
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Missing value for " << arg << std::endl;
+			return false;
+		}
+
+		if (arg == "--randomizer")
+		{
+			if (!utils::randomizer_from_name(argv[++i], options.randomizer))
+			{
+				std::cerr << "Unknown randomizer " << argv[i] << std::endl;
+				return false;
+			}
+			continue;
+		}
+
+		if (arg == "--trace")
+		{
+			options.trace = argv[++i];
+			continue;
+		}
+
+		/* std::stoull takes a sign and stops at the first non digit, both are rejected */
+		const std::string text = argv[++i];
+		UInt64 value = 0;
+		Size parsed = 0;
+		try
+		{
+			value = std::stoull(text, &parsed);
+		}
+		catch (const std::invalid_argument&) { parsed = 0; }
+		catch (const std::out_of_range&) { parsed = 0; }
+
+		if (parsed == 0 || parsed != text.size() || text.front() == '-' || text.front() == '+' || (arg != "--seed" && value > std::numeric_limits<unsigned int>::max()))
+		{
+			std::cerr << "Invalid value " << text << " for " << arg << std::endl;
+			return false;
+		}
+
+		if (arg == "--games") options.games = static_cast<unsigned int>(value);
+		else if (arg == "--threads") options.threads = std::max(1U, static_cast<unsigned int>(value));
+		else if (arg == "--seed") options.seed = value;
+		else if (arg == "--max-pieces") options.maxPieces = static_cast<unsigned int>(value);
+		else if (arg == "--level") options.level = static_cast<unsigned int>(value);
+		else if (arg == "--tick-us") options.tick = core::Time{ static_cast<Int64>(std::max<UInt64>(1, value)) };
+		else if (arg == "--previews") options.bot.previews = static_cast<unsigned int>(value);
+		else if (arg == "--beam") options.bot.beamWidth = static_cast<unsigned int>(value);
+		else if (arg == "--scaling") options.scaling = std::max(1U, static_cast<unsigned int>(value));
+		else
+		{
+			std::cerr << "Unknown option " << arg << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static GameResult play_game(const Options& options, UInt64 seed)
+{
+	GameResult result;
+	result.seed = seed;
+
+	core::Scenario scenario{ seed, options.randomizer };
+	scenario.setStartLevel(options.level);
+
+	core::Bot bot{ {}, options.bot };
+
+	while (scenario.state() == core::Scenario::State::Running && scenario.spawnCount() < options.maxPieces)
+	{
+		bot.update(scenario);
+		scenario.update(options.tick);
+		result.ticks++;
+	}
+
+	result.pieces = scenario.spawnCount();
+	result.lines = scenario.score().lines();
+	result.points = scenario.score().points();
+	result.toppedOut = scenario.state() == core::Scenario::State::GameOver;
+	return result;
+}
+
+static void measure_scaling(const Options& options)
+{
+	/* Searches an empty field are shallow, so the position is taken some pieces into a game */
+	core::Scenario scenario{ options.seed, options.randomizer };
+	scenario.setStartLevel(options.level);
+
+	core::Bot bot{ {}, options.bot };
+	while (scenario.state() == core::Scenario::State::Running && scenario.spawnCount() < scaling_pieces)
+	{
+		bot.update(scenario);
+		scenario.update(options.tick);
+	}
+
+	const unsigned int width = options.bot.beamWidth > 0 ? options.bot.beamWidth : scaling_beam_width;
+	const unsigned int previews = options.bot.previews > 0 ? options.bot.previews : core::TetrominoManager::next_count;
+	const auto results = core::BeamSearch::measureScaling(scenario, bot.evaluator(), width, previews, options.scaling, scaling_repeats);
+
+	std::cout << "beam " << width << ", previews " << previews << ", seed " << options.seed << ", piece " << scenario.spawnCount()
+		<< ", " << scaling_repeats << " searches per thread count" << std::endl;
+	for (const auto& result : results)
+		std::cout << "threads " << std::setw(3) << result.threads
+			<< "  nodes/s " << std::setw(14) << std::fixed << std::setprecision(0) << result.nodesPerSecond
+			<< "  efficiency " << std::setw(6) << std::setprecision(1) << (result.efficiency * 100.0) << " %" << std::endl;
+}
+
+template<typename _Ty>
+static _Ty percentile(const std::vector<_Ty>& sorted, double fraction)
+{
+	if (sorted.empty())
+		return _Ty{};
+
+	const Size index = static_cast<Size>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+template<typename _Ty>
+static void print_distribution(const char* name, std::vector<_Ty> values)
+{
+	std::sort(values.begin(), values.end());
+	const double mean = values.empty() ? 0.0 : static_cast<double>(std::accumulate(values.begin(), values.end(), UInt64{ 0 })) / static_cast<double>(values.size());
+
+	std::cout << std::left << std::setw(14) << name << std::right
+		<< " mean " << std::setw(12) << std::fixed << std::setprecision(1) << mean
+		<< "  min " << std::setw(10) << (values.empty() ? _Ty{} : values.front())
+		<< "  p50 " << std::setw(10) << percentile(values, 0.50)
+		<< "  p90 " << std::setw(10) << percentile(values, 0.90)
+		<< "  p99 " << std::setw(10) << percentile(values, 0.99)
+		<< "  max " << std::setw(10) << (values.empty() ? _Ty{} : values.back())
+		<< std::endl;
+}
+
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parse_options(argc, argv, options))
+	{
+		print_usage();
+		return 1;
+	}
+
+	if (options.scaling > 0)
+	{
+		measure_scaling(options);
+		return 0;
+	}
+
+	std::vector<GameResult> results(options.games);
+	std::atomic<unsigned int> nextGame{ 0 };
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < std::min(options.threads, std::max(1U, options.games)); i++)
+		workers.emplace_back([&]()
+		{
+			for (unsigned int game = nextGame++; game < options.games; game = nextGame++)
+				results[game] = play_game(options, options.seed + game);
+		});
+	for (auto& worker : workers)
+		worker.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	UInt64 pieces = 0, ticks = 0, toppedOut = 0;
+	std::vector<UInt64> lengths, lines, points;
+	for (const auto& result : results)
+	{
+		pieces += result.pieces;
+		ticks += result.ticks;
+		toppedOut += result.toppedOut ? 1 : 0;
+		lengths.push_back(result.pieces);
+		lines.push_back(result.lines);
+		points.push_back(result.points);
+	}
+
+	std::cout << "games " << options.games << " on " << workers.size() << " threads, " << utils::randomizer_name(options.randomizer) << ", seeds "
+		<< options.seed << ".." << (options.seed + std::max(1U, options.games) - 1)
+		<< ", topped out " << toppedOut << std::endl;
+	std::cout << std::fixed << std::setprecision(2)
+		<< "elapsed       " << seconds << " s" << std::endl
+		<< "games/s       " << (options.games / seconds) << std::endl
+		<< "pieces/s      " << (pieces / seconds) << std::endl
+		<< "ticks/s       " << (ticks / seconds) << std::endl;
+
+	print_distribution("length (pcs)", lengths);
+	print_distribution("lines", lines);
+	print_distribution("score", points);
+
+	if (!options.trace.empty() && !core::trace::dump(options.trace))
+	{
+		std::cerr << "Cannot write " << options.trace << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -39,6 +39,8 @@ Sound& SoundManager::_load(const Path& filepath, const String& name)
 
 void SoundManager::loadAll()
 {
+	CORE_TRACE_ZONE("SoundManager::loadAll");
+
 	Json json;
 	resource::sound.readJson("config.json", json);
 
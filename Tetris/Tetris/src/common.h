@@ -30,27 +30,17 @@
 
 #include <nlohmann/json.hpp>
 
+#include "core/basics.h"
+#include "core/trace.h"
+
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 
 
-typedef std::uint8_t UInt8;
-typedef std::uint16_t UInt16;
-typedef std::uint32_t UInt32;
-typedef std::uint64_t UInt64;
-
-typedef std::int8_t Int8;
-typedef std::int16_t Int16;
-typedef std::int32_t Int32;
-typedef std::int64_t Int64;
-
 typedef std::string String;
 
 typedef std::byte Byte;
 
-typedef std::size_t Size;
-typedef std::size_t Offset;
-
 typedef std::filesystem::path Path;
 
 typedef sf::Vector2f Vec2f;
@@ -115,23 +105,6 @@ namespace utils
 		return (base & ~(mask << _BitIdx)) | value;
 	}
 
-	template<typename _ValueTy, typename _MinTy, typename _MaxTy>
-	constexpr _ValueTy clamp(_ValueTy value, _MinTy min, _MaxTy max)
-	{
-		if constexpr (std::same_as< _MinTy, _ValueTy>)
-		{
-			if constexpr (std::same_as< _MaxTy, _ValueTy>)
-				return std::max(std::min(max, value), min);
-			else return std::max(std::min(static_cast<_ValueTy>(max), value), min);
-		}
-		else
-		{
-			if constexpr (std::same_as< _MaxTy, _ValueTy>)
-				return std::max(std::min(max, value), static_cast<_ValueTy>(min));
-			else return std::max(std::min(static_cast<_ValueTy>(max), value), static_cast<_ValueTy>(min));
-		}
-	}
-
 	template<Size _BufSize = 8192>
 	void stream_copy(std::ostream& dst, std::istream& src, Size byte_count = 0)
 	{
@@ -159,6 +132,8 @@ namespace utils
 		return { static_cast<_DstTy>(v.x), static_cast<_DstTy>(v.y) };
 	}
 
+	inline core::Time time_cast(const sf::Time& time) { return core::Time{ time.asMicroseconds() }; }
+
 
 	void centrate_text(sf::Text& text, const Vec2f& position, const Vec2f& size);
 }
@@ -384,6 +359,7 @@ namespace resource
 	static const Folder root = "data"_p;
 	static const Folder textures = { root, "textures"_p };
 	static const Folder themes = { root, "themes"_p };
+	static const Folder modes = { root, "modes"_p };
 	static const Folder font = { root, "font"_p };
 	static const Folder music = { root, "audio"_p / "music"_p };
 	static const Folder sound = { root, "audio"_p / "sound"_p };
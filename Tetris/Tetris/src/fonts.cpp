@@ -19,6 +19,8 @@ Font& FontManager::load(const String& filename, const String& name)
 
 void FontManager::loadAll()
 {
+	CORE_TRACE_ZONE("FontManager::loadAll");
+
 	Json json;
 	resource::font.readJson("config.json", json);
 
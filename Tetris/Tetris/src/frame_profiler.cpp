@@ -0,0 +1,159 @@
+#include "frame_profiler.h"
+
+#include <iomanip>
+#include <numeric>
+
+#include "fonts.h"
+
+
+void FrameProfiler::init()
+{
+	_samples.resize(capacity);
+	_sorted.reserve(capacity);
+
+	_text.setFillColor(sf::Color::Green);
+	_text.setCharacterSize(18);
+	_text.setFont(global::fonts["arial"]);
+	_text.setPosition(10, 10);
+
+	_graphBackground.setFillColor(sf::Color{ 0, 0, 0, 160 });
+	_graphBackground.setSize({ graph_frames * graph_bar_width, graph_height });
+	_graphBackground.setPosition(10, 100);
+}
+
+void FrameProfiler::frame()
+{
+	if (!_enabled)
+	{
+		_running = false;
+		return;
+	}
+
+	const Int64 end = now();
+	if (!_running)
+	{
+		/* Just shown. Whatever was timed while hidden is not a frame */
+		_reset(end);
+		return;
+	}
+
+	Sample& sample = _samples[_next];
+	sample.end = end;
+	sample.frame = end - _frameStart;
+	for (int i = 0; i < stage_count; i++)
+		sample.stages[i] = _pending[i].exchange(0);
+	sample.ticks = _pendingTicks.exchange(0);
+	sample.hitch = sample.frame > _hitchThreshold;
+
+	if (sample.hitch)
+		_hitches++;
+
+	_next = (_next + 1) % capacity;
+	_count = std::min(_count + 1, capacity);
+	_frameStart = end;
+
+	if (end - _lastText >= text_refresh)
+		_updateText(end);
+	_updateGraph();
+}
+
+void FrameProfiler::render(sf::RenderTarget& canvas)
+{
+	if (_enabled && _running)
+	{
+		canvas.draw(_graphBackground);
+		canvas.draw(_graph);
+		canvas.draw(_text);
+	}
+}
+
+void FrameProfiler::_reset(Int64 now)
+{
+	for (auto& pending : _pending)
+		pending = 0;
+	_pendingTicks = 0;
+
+	_count = 0;
+	_next = 0;
+	_hitches = 0;
+	_running = true;
+	_frameStart = now;
+	_lastText = 0;
+
+	_text.setString("");
+	_graph.clear();
+}
+
+void FrameProfiler::_updateText(Int64 now)
+{
+	_lastText = now;
+
+	Int64 stages[stage_count] = {};
+	UInt64 ticks = 0;
+
+	_sorted.clear();
+	for (Size age = 0; age < _count && now - _sample(age).end < window; age++)
+	{
+		const Sample& sample = _sample(age);
+		_sorted.push_back(sample.frame);
+		for (int i = 0; i < stage_count; i++)
+			stages[i] += sample.stages[i];
+		ticks += sample.ticks;
+	}
+
+	if (_sorted.empty())
+		return;
+
+	const Size frames = _sorted.size();
+	const auto percentile = [this, frames](double fraction) {
+		const auto nth = _sorted.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(frames - 1) + 0.5);
+		std::nth_element(_sorted.begin(), nth, _sorted.end());
+		return *nth;
+	};
+	const Int64 p50 = percentile(0.50);
+	const Int64 p99 = percentile(0.99);
+	const Int64 max = *std::max_element(_sorted.begin(), _sorted.end());
+
+	_hitchThreshold = std::max<Int64>(p50 * hitch_factor, 1000);
+
+	const auto ms = [](double microseconds) {
+		std::ostringstream ss;
+		ss << std::fixed << std::setprecision(2) << (microseconds / 1000.0);
+		return ss.str();
+	};
+	const auto mean = [frames](Int64 total) { return static_cast<double>(total) / static_cast<double>(frames); };
+
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(1)
+		<< (1000000.0 / mean(std::accumulate(_sorted.begin(), _sorted.end(), Int64{ 0 }))) << " fps, last " << (window / 1000000) << " s\n"
+		<< "frame p50 " << ms(static_cast<double>(p50)) << "  p99 " << ms(static_cast<double>(p99)) << "  max " << ms(static_cast<double>(max)) << " ms\n"
+		<< "events " << ms(mean(stages[static_cast<int>(Stage::Events)]))
+		<< "  update " << ms(mean(stages[static_cast<int>(Stage::Update)]))
+		<< "  render " << ms(mean(stages[static_cast<int>(Stage::Render)]))
+		<< "  present " << ms(mean(stages[static_cast<int>(Stage::Present)])) << " ms\n"
+		<< "ticks/frame " << (static_cast<double>(ticks) / static_cast<double>(frames)) << "  hitches " << _hitches;
+
+	_text.setString(ss.str());
+	_graphBackground.setPosition(10, _text.getGlobalBounds().top + _text.getGlobalBounds().height + 10);
+}
+
+void FrameProfiler::_updateGraph()
+{
+	/* One bar per frame, newest at the right. Hitches in red */
+	_graph.clear();
+
+	const Vec2f origin = _graphBackground.getPosition() + Vec2f{ 0, graph_height };
+	const Size bars = std::min(_count, graph_frames);
+	for (Size age = 0; age < bars; age++)
+	{
+		const Sample& sample = _sample(age);
+		const float height = std::min(graph_height, static_cast<float>(sample.frame) / 1000.f * (graph_height / graph_ms));
+		const float left = origin.x + (static_cast<float>(graph_frames - 1 - age) * graph_bar_width);
+		const sf::Color color = sample.hitch ? sf::Color::Red : sf::Color::Green;
+
+		_graph.append({ { left, origin.y - height }, color });
+		_graph.append({ { left + graph_bar_width, origin.y - height }, color });
+		_graph.append({ { left + graph_bar_width, origin.y }, color });
+		_graph.append({ { left, origin.y }, color });
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+
+#include "common.h"
+
+
+/*
+ * Frame time overlay. Stages are timed on the thread that runs them and summed into the frame
+ * that is presented next: events on the window thread, update on the simulation thread, render
+ * and present on the render thread. While hidden nothing reads a clock.
+ */
+class FrameProfiler
+{
+public:
+	enum class Stage
+	{
+		Events,
+		Update,
+		Render,
+		Present
+	};
+
+	static constexpr int stage_count = 4;
+
+	/* Frames kept for the statistics, by age and by amount */
+	static constexpr Int64 window = 5000000;
+	static constexpr Size capacity = 4096;
+
+	static constexpr Size graph_frames = 240;
+	static constexpr float graph_bar_width = 2.f;
+	static constexpr float graph_height = 100.f;
+	static constexpr float graph_ms = 50.f;
+
+	/* Frames longer than this many times the median one count as hitches */
+	static constexpr Int64 hitch_factor = 2;
+
+	static constexpr Int64 text_refresh = 250000;
+
+	/* Adds the time until its destruction to a stage of the current frame */
+	class Scope
+	{
+	private:
+		FrameProfiler* _profiler;
+		Stage _stage;
+		Int64 _start;
+
+	public:
+		Scope(const Scope&) = delete;
+		Scope(Scope&&) noexcept = delete;
+
+		Scope& operator= (const Scope&) = delete;
+		Scope& operator= (Scope&&) noexcept = delete;
+
+		inline Scope(FrameProfiler& profiler, Stage stage) :
+			_profiler{ profiler.enabled() ? &profiler : nullptr },
+			_stage{ stage },
+			_start{ _profiler ? FrameProfiler::now() : 0 }
+		{}
+		inline ~Scope()
+		{
+			if (_profiler)
+				_profiler->add(_stage, FrameProfiler::now() - _start);
+		}
+	};
+
+private:
+	struct Sample
+	{
+		Int64 end = 0;
+		Int64 frame = 0;
+		Int64 stages[stage_count] = {};
+		UInt32 ticks = 0;
+		bool hitch = false;
+	};
+
+private:
+	std::atomic<bool> _enabled = false;
+	std::atomic<Int64> _pending[stage_count] = {};
+	std::atomic<UInt32> _pendingTicks = 0;
+
+	bool _running = false;
+	Int64 _frameStart = 0;
+	Int64 _lastText = 0;
+	Int64 _hitchThreshold = 50000;
+	UInt64 _hitches = 0;
+
+	std::vector<Sample> _samples;
+	Size _next = 0;
+	Size _count = 0;
+	std::vector<Int64> _sorted;
+
+	sf::Text _text;
+	sf::VertexArray _graph{ sf::Quads };
+	sf::RectangleShape _graphBackground;
+
+public:
+	void init();
+
+	inline bool enabled() const { return _enabled; }
+	inline void enabled(bool flag) { _enabled = flag; }
+	inline void toggle() { _enabled = !_enabled; }
+
+	/* Any thread */
+	inline void add(Stage stage, Int64 microseconds) { _pending[static_cast<int>(stage)] += microseconds; }
+	inline void addTick() { if (_enabled) _pendingTicks++; }
+
+	/* Render thread, once per presented frame */
+	void frame();
+	void render(sf::RenderTarget& canvas);
+
+	static inline Int64 now() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+private:
+	void _reset(Int64 now);
+
+	void _updateText(Int64 now);
+	void _updateGraph();
+
+	inline const Sample& _sample(Size age) const { return _samples[(_next + capacity - 1 - age) % capacity]; }
+};
@@ -21,27 +21,111 @@ Json& operator>> (Json& left, UID& right) { return right._value = left.get<UInt6
 
 
 
-Frame::Frame(const Vec2u& textureSize, const Vec2f& shapeSize, const Vec2f& shapePosition) :
+Frame::Frame(const Vec2u& textureSize, const Vec2f& shapeSize, const Vec2f& shapePosition, Composition composition) :
 	_canvas{},
-	_shape{}
+	_shape{},
+	_canvasSize{ textureSize },
+	_composition{ composition }
 {
-	_canvas.create(textureSize.x, textureSize.y);
-
 	_shape.setPosition(shapePosition);
 	_shape.setSize(shapeSize);
 
-	_shape.setTexture(&_canvas.getTexture(), true);
+	_createCanvas();
 }
 
 void Frame::rebuild(const Vec2u& textureSize, const Vec2f& shapeSize, const Vec2f& shapePosition)
 {
-	utils::destroy(_canvas);
-	utils::construct(_canvas);
-
-	_canvas.create(textureSize.x, textureSize.y);
+	_canvasSize = textureSize;
 
 	_shape.setPosition(shapePosition);
 	_shape.setSize(shapeSize);
 
-	_shape.setTexture(&_canvas.getTexture(), true);
+	_createCanvas();
+}
+
+void Frame::setComposition(Composition composition)
+{
+	if (_composition != composition)
+	{
+		_composition = composition;
+		_createCanvas();
+	}
+}
+
+bool Frame::beginCanvas(sf::RenderTarget& parent, const sf::RenderStates& states)
+{
+	if (_composition == Composition::Cached)
+	{
+		_target = &_canvas;
+		_states = sf::RenderStates::Default;
+		if (_dirty)
+			_canvas.clear();
+		return _dirty;
+	}
+
+	/* Background and perimeter, what the cleared canvas would have shown */
+	parent.draw(_shape, states);
+
+	_target = &parent;
+	_states = states;
+	_states.transform *= contentTransform();
+
+	/*
+	 * Scissoring: a view over the pixels the frame covers, which maps coordinates like the parent view
+	 * but clips everything outside of them. Built back from whole pixels so nothing moves by rounding.
+	 */
+	_parentView = parent.getView();
+
+	const sf::FloatRect area = states.transform.transformRect({ _shape.getPosition(), _shape.getSize() });
+	const Vec2i topLeft = parent.mapCoordsToPixel({ area.left, area.top }, _parentView);
+	const Vec2i bottomRight = parent.mapCoordsToPixel({ area.left + area.width, area.top + area.height }, _parentView);
+	const Vec2f from = parent.mapPixelToCoords(topLeft, _parentView);
+	const Vec2f to = parent.mapPixelToCoords(bottomRight, _parentView);
+	const Vec2f targetSize = static_cast<Vec2f>(parent.getSize());
+
+	sf::View clip{ { from.x, from.y, to.x - from.x, to.y - from.y } };
+	clip.setViewport({
+		static_cast<float>(topLeft.x) / targetSize.x,
+		static_cast<float>(topLeft.y) / targetSize.y,
+		static_cast<float>(bottomRight.x - topLeft.x) / targetSize.x,
+		static_cast<float>(bottomRight.y - topLeft.y) / targetSize.y
+	});
+	parent.setView(clip);
+
+	return true;
+}
+
+void Frame::endCanvas(sf::RenderTarget& parent, const sf::RenderStates& states)
+{
+	if (_composition == Composition::Cached)
+	{
+		if (_dirty)
+			_canvas.display();
+		parent.draw(_shape, states);
+	}
+	else
+		parent.setView(_parentView);
+
+	_dirty = false;
+	_target = nullptr;
+}
+
+void Frame::_createCanvas()
+{
+	utils::destroy(_canvas);
+	utils::construct(_canvas);
+
+	if (_composition == Composition::Cached)
+	{
+		_canvas.create(_canvasSize.x, _canvasSize.y);
+		_shape.setTexture(&_canvas.getTexture(), true);
+		_shape.setFillColor(sf::Color::White);
+	}
+	else
+	{
+		_shape.setTexture(nullptr);
+		_shape.setFillColor(sf::Color::Black);
+	}
+
+	_dirty = true;
 }
@@ -43,6 +43,9 @@ struct Updatable
 struct EventDispatcher
 {
 	virtual void dispatchEvent(const sf::Event& event) = 0;
+
+	/* Event that happened offset into the next update. Objects that ignore timing get a plain dispatchEvent */
+	virtual void dispatchTimedEvent(const sf::Event& event, const sf::Time& offset) { dispatchEvent(event); }
 };
 
 
@@ -68,6 +71,7 @@ public:
 	virtual void render(sf::RenderTarget& canvas) override {}
 	virtual void update(const sf::Time& delta) override {}
 	virtual void dispatchEvent(const sf::Event& event) override {}
+	virtual void dispatchTimedEvent(const sf::Event& event, const sf::Time& offset) override { dispatchEvent(event); }
 };
 
 
@@ -281,12 +285,27 @@ public:
 
 class Frame
 {
+public:
+	/*
+	 * Cached frames draw their content into a texture of their own and reuse it while nothing changes.
+	 * Direct frames draw it straight into the parent target through a transform, clipped to the frame
+	 * by a view, so they cost no offscreen pass and no texture memory.
+	 */
+	enum class Composition { Cached, Direct };
+
 private:
 	sf::RectangleShape _shape;
 	sf::RenderTexture _canvas;
+	Vec2u _canvasSize;
+	Composition _composition;
+	bool _dirty = true;
+
+	sf::RenderTarget* _target = nullptr;
+	sf::RenderStates _states;
+	sf::View _parentView;
 
 public:
-	Frame(const Vec2u& textureSize, const Vec2f& shapeSize = {}, const Vec2f& shapePosition = {});
+	Frame(const Vec2u& textureSize, const Vec2f& shapeSize = {}, const Vec2f& shapePosition = {}, Composition composition = Composition::Direct);
 	Frame(const Frame&) = delete;
 	Frame(Frame&&) noexcept = default;
 	virtual ~Frame() = default;
@@ -300,19 +319,46 @@ public:
 	inline void setPosition(const Vec2f& position) { _shape.setPosition(position); }
 	inline void setSize(const Vec2f& size) { _shape.setSize(size); }
 
-	inline Vec2u getCanvasSize() const { return _canvas.getSize(); }
+	inline Vec2u getCanvasSize() const { return _canvasSize; }
+
+	/* Maps canvas coordinates to where they end up in the parent, for content drawn without the canvas */
+	inline sf::Transform contentTransform() const
+	{
+		sf::Transform transform;
+		transform.translate(_shape.getPosition());
+		transform.scale(_shape.getSize().x / static_cast<float>(_canvasSize.x), _shape.getSize().y / static_cast<float>(_canvasSize.y));
+		return transform;
+	}
 
 	inline void setPerimeterColor(const sf::Color& color) { _shape.setOutlineColor(color); }
 	inline void setPerimeterThickness(float thickness) { _shape.setOutlineThickness(thickness); }
 
+	void setComposition(Composition composition);
+	inline Composition composition() const { return _composition; }
+
+	/*
+	 * A cached canvas keeps its last content. Frames redraw it only while dirty and otherwise just
+	 * draw the cached texture, so they invalidate themselves when what they show changes.
+	 */
+	inline void invalidate() { _dirty = true; }
+	inline bool isDirty() const { return _dirty; }
+
 protected:
 	void rebuild(const Vec2u& textureSize, const Vec2f& shapeSize = {}, const Vec2f& shapePosition = {});
 
-	inline void clearCanvas() { _canvas.clear(); }
-	inline void displayCanvas() { _canvas.display(); }
-	inline void renderCanvas(sf::RenderTarget& canvas, bool display = true) { if (display) _canvas.display(); canvas.draw(_shape); }
-	inline void draw(const sf::Drawable& drawable) { _canvas.draw(drawable); }
-	inline sf::RenderTarget& canvas() { return _canvas; }
+	/* Starts drawing the content into canvas(). False when a cached canvas is still valid and there is nothing to draw */
+	bool beginCanvas(sf::RenderTarget& parent, const sf::RenderStates& states = sf::RenderStates::Default);
+
+	/* Puts the content on the parent. Takes the same arguments as beginCanvas */
+	void endCanvas(sf::RenderTarget& parent, const sf::RenderStates& states = sf::RenderStates::Default);
+
+	/* Valid between beginCanvas and endCanvas. Children render into canvas() with canvasStates() */
+	inline void draw(const sf::Drawable& drawable) { _target->draw(drawable, _states); }
+	inline sf::RenderTarget& canvas() { return *_target; }
+	inline const sf::RenderStates& canvasStates() const { return _states; }
+
+private:
+	void _createCanvas();
 };
 
 
@@ -327,4 +373,7 @@ namespace default_control
 	constexpr KeyboardKey rotate_left = KeyboardKey::Z;
 	constexpr KeyboardKey rotate_right = KeyboardKey::Up;
 	constexpr KeyboardKey hold = KeyboardKey::C;
+
+	constexpr KeyboardKey profiler = KeyboardKey::F3;
+	constexpr KeyboardKey trace_dump = KeyboardKey::F4;
 }
@@ -10,25 +10,32 @@ GameController::GameController(const std::string& name) :
 	GameObjectContainer{},
 	_close{ true },
 	_window{},
-	_deltaClock{},
+	_clock{},
+	_phLast{},
 	_phAccumulator{},
-	_phUps{},
+	_phStep{},
+	_phMaxSteps{ default_max_catch_up_ticks },
+	_phTicks{ 0 },
+	_phInterpolation{ 0 },
+	_inputMutex{},
+	_inputs{},
+	_pendingInputs{},
 	_name{ name },
 	_vmode{ 640, 480 },
 	_wstyle{ WindowStyle::Default },
+	_renderPath{ RenderPath::Native },
 	_virtualCanvas{},
 	_virtualWindow{},
 	_view{},
-	_fps{}
+	_profiler{}
 {
-	_virtualCanvas.create(canvas_width, canvas_height);
-
 	_virtualWindow.setSize({ static_cast<float>(canvas_width), static_cast<float>(canvas_height) });
 	_virtualWindow.setPosition(0, 0);
-	_virtualWindow.setTexture(&_virtualCanvas.getTexture());
 
 	_view.setSize({ static_cast<float>(canvas_width), static_cast<float>(canvas_height) });
 	_view.setCenter({ static_cast<float>(canvas_width / 2), static_cast<float>(canvas_height / 2) });
+
+	tickRate(default_tick_rate);
 }
 GameController::~GameController() {}
 
@@ -77,63 +84,156 @@ void GameController::resetWindow()
 
 bool GameController::fullscreen() const { return (_wstyle & WindowStyle::Fullscreen) == WindowStyle::None; }
 
+void GameController::tickRate(unsigned int rate)
+{
+	rate = utils::clamp(rate, 1U, 1000000U);
+	_phStep = sf::microseconds(1000000 / rate);
+}
+
 void GameController::loop()
 {
+	CORE_TRACE_THREAD("window");
+
+	/* The render thread takes the window context, events stay on the thread that created the window */
+	_window.setActive(false);
+
+	std::thread simulation{ &GameController::simulate, this };
+	std::thread rendering{ &GameController::present, this };
+
 	while (!_close)
 	{
 		processEvents();
+		sf::sleep(sf::milliseconds(1));
+	}
+
+	rendering.join();
+	simulation.join();
+
+	_window.setActive(true);
+}
+
+void GameController::simulate()
+{
+	CORE_TRACE_THREAD("simulation");
+
+	_phAccumulator = sf::Time::Zero;
+	_phLast = _clock.getElapsedTime();
+
+	while (!_close)
+	{
 		update();
-		render();
+
+		if (_phAccumulator < _phStep)
+			sf::sleep(_phStep - _phAccumulator);
 	}
 }
 
+void GameController::present()
+{
+	CORE_TRACE_THREAD("render");
+
+	_window.setActive(true);
+
+	while (!_close)
+		render();
+
+	_window.setActive(false);
+}
+
 void GameController::init()
 {
-	_fps.init();
-	_fps.enabled(true);
+	_profiler.init();
 	resetWindow();
+
+	if (_renderPath == RenderPath::Virtual)
+	{
+		_virtualCanvas.create(canvas_width, canvas_height);
+		_virtualWindow.setTexture(&_virtualCanvas.getTexture(), true);
+	}
 }
 void GameController::update()
 {
 	if (!_close)
 	{
-		sf::Time delta = _deltaClock.restart();
-		_phAccumulator += delta;
+		CORE_TRACE_ZONE("GameController::update");
+		FrameProfiler::Scope scope{ _profiler, FrameProfiler::Stage::Update };
+
+		const sf::Time now = _clock.getElapsedTime();
+		_phAccumulator += now - _phLast;
+		_phLast = now;
 
-		if (_phAccumulator > _phUps)
+		const sf::Time maxAccumulated = _phStep * static_cast<sf::Int64>(_phMaxSteps);
+		if (_phAccumulator > maxAccumulated)
+			_phAccumulator = maxAccumulated;
+
+		/* Real time covered by the next tick, so events land at their offset inside it */
+		sf::Time tickStart = now - _phAccumulator;
+		while (_phAccumulator >= _phStep)
 		{
-			_phAccumulator -= _phUps;
-			_fps.update(delta);
+			dispatchInputs(tickStart, tickStart + _phStep);
+
+			_phAccumulator -= _phStep;
+			tickStart += _phStep;
+			_phTicks++;
+			_profiler.addTick();
 			for (GameObject& obj : *this)
-				obj.update(delta);
+				obj.update(_phStep);
 		}
+
+		_phInterpolation = _phAccumulator / _phStep;
 	}
 }
 void GameController::render()
 {
 	if (!_close)
 	{
-		_window.clear();
-		_virtualCanvas.clear();
+		CORE_TRACE_ZONE("GameController::render");
 
-		for (GameObject& obj : *this)
-			obj.render(_virtualCanvas);
+		{
+			FrameProfiler::Scope scope{ _profiler, FrameProfiler::Stage::Render };
 
-		_virtualCanvas.display();
+			_window.clear();
 
-		_window.setView(_view);
-		_window.draw(_virtualWindow);
-		_window.setView(_window.getDefaultView());
+			if (_renderPath == RenderPath::Native)
+			{
+				/* The view scales the layout, so everything is rasterized at the window resolution */
+				_window.setView(_view);
+				for (GameObject& obj : *this)
+					obj.render(_window);
+			}
+			else
+			{
+				_virtualCanvas.clear();
+
+				for (GameObject& obj : *this)
+					obj.render(_virtualCanvas);
+
+				_virtualCanvas.display();
+
+				_window.setView(_view);
+				_window.draw(_virtualWindow);
+			}
 
-		_fps.render(_window);
+			_window.setView(_window.getDefaultView());
+
+			_profiler.render(_window);
+		}
+
+		{
+			FrameProfiler::Scope scope{ _profiler, FrameProfiler::Stage::Present };
+			_window.display();
+		}
 
-		_window.display();
+		_profiler.frame();
 	}
 }
 void GameController::processEvents()
 {
 	if (!_close)
 	{
+		CORE_TRACE_ZONE("GameController::processEvents");
+		FrameProfiler::Scope scope{ _profiler, FrameProfiler::Stage::Events };
+
 		sf::Event event;
 		while (_window.pollEvent(event))
 		{
@@ -142,51 +242,44 @@ void GameController::processEvents()
 				_close = true;
 				return;
 			}
-			for (GameObject& obj : *this)
-				obj.dispatchEvent(event);
-		}
-	}
-}
-
-void GameController::onCreate(GameObject& obj)
-{
-}
-void GameController::onDestroy(GameObject& obj)
-{
-}
-
-
-
-void FPSMonitor::init()
-{
-	_text.setFillColor(sf::Color::Green);
-	_text.setCharacterSize(24);
 
-	_text.setFont(global::fonts["arial"]);
+			if (event.type == sf::Event::KeyPressed && event.key.code == default_control::profiler)
+				_profiler.toggle();
 
-	_text.setPosition(10, 10);
+#ifdef TETRIS_TRACE
+			if (event.type == sf::Event::KeyPressed && event.key.code == default_control::trace_dump)
+				core::trace::dump(trace_filename);
+#endif
 
-	_text.setString("0 fps");
+			std::lock_guard<std::mutex> lock{ _inputMutex };
+			_inputs.push_back({ event, _clock.getElapsedTime() });
+		}
+	}
 }
-
-void FPSMonitor::update(const sf::Time& delta)
+void GameController::dispatchInputs(const sf::Time& tickStart, const sf::Time& tickEnd)
 {
-	_remaining -= static_cast<Int64>(delta.asMicroseconds());
-	_current++;
+	{
+		std::lock_guard<std::mutex> lock{ _inputMutex };
+		_pendingInputs.insert(_pendingInputs.end(), _inputs.begin(), _inputs.end());
+		_inputs.clear();
+	}
 
-	while (_remaining < 0)
+	/* Events arrive stamped in order. Late ones, from time dropped by the catch-up limit, go at the start */
+	while (!_pendingInputs.empty() && _pendingInputs.front().time < tickEnd)
 	{
-		_remaining += identity;
-		_last = _current;
-		_current = 0;
+		const TimedEvent& input = _pendingInputs.front();
+		const sf::Time offset = input.time > tickStart ? input.time - tickStart : sf::Time::Zero;
 
-		_text.setString(std::to_string(_last) + " fps");
+		for (GameObject& obj : *this)
+			obj.dispatchTimedEvent(input.event, offset);
+		_pendingInputs.pop_front();
 	}
 }
-void FPSMonitor::render(sf::RenderTarget& canvas)
+
+void GameController::onCreate(GameObject& obj)
 {
-	if (_enabled)
-	{
-		canvas.draw(_text);
-	}
 }
+void GameController::onDestroy(GameObject& obj)
+{
+}
+
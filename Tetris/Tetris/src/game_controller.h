@@ -1,6 +1,12 @@
 #pragma once
 
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+
 #include "game_basics.h"
+#include "frame_profiler.h"
 
 enum class WindowStyle : UInt32
 {
@@ -13,51 +19,59 @@ enum class WindowStyle : UInt32
 	Default = Titlebar | Resize | Close ///< Default window style
 };
 
-class FPSMonitor
+/* How the logical 1920x1080 layout reaches the window */
+enum class RenderPath
 {
-private:
-	static constexpr Int64 identity = 1000000;
-
-	Int64 _remaining = identity;
-	unsigned int _current = 0;
-	unsigned int _last = 0;
-	bool _enabled = false;
-
-	sf::Text _text;
-
-public:
-	void init();
-
-	void update(const sf::Time& delta);
-	void render(sf::RenderTarget& canvas);
-
-	inline bool enabled() const { return _enabled; }
-	inline void enabled(bool flag) { _enabled = flag; }
+	Native,  ///< Drawn straight into the window through a scaling view, at the window resolution
+	Virtual  ///< Drawn into a 1920x1080 texture that is then stretched over the window
 };
 
 class GameController : private GameObjectContainer<GameObject>
 {
+private:
+	struct TimedEvent
+	{
+		sf::Event event;
+		sf::Time time;
+	};
+
 public:
 	static constexpr int canvas_width = utils::game_canvas_with;
 	static constexpr int canvas_height = utils::game_canvas_height;
 
+	static constexpr unsigned int default_tick_rate = 240;
+	static constexpr unsigned int default_max_catch_up_ticks = 30;
+
+	/* Written with the zones recorded so far when default_control::trace_dump is pressed, in TETRIS_TRACE builds */
+	static constexpr const char* trace_filename = "trace.json";
+
 private:
-	bool _close;
+	std::atomic<bool> _close;
 	sf::RenderWindow _window;
 
-	sf::Clock _deltaClock;
+	sf::Clock _clock;
+	sf::Time _phLast;
 	sf::Time _phAccumulator;
-	sf::Time _phUps;
+	sf::Time _phStep;
+	unsigned int _phMaxSteps;
+	std::atomic<UInt64> _phTicks;
+	std::atomic<float> _phInterpolation;
+
+	std::mutex _inputMutex;
+	std::vector<TimedEvent> _inputs;
+	std::deque<TimedEvent> _pendingInputs;
+
 
 	std::string _name;
 	sf::VideoMode _vmode;
 	WindowStyle _wstyle;
 
+	RenderPath _renderPath;
 	sf::RenderTexture _virtualCanvas;
 	sf::RectangleShape _virtualWindow;
 	sf::View _view;
 
-	FPSMonitor _fps;
+	FrameProfiler _profiler;
 
 public:
 	GameController(const GameController&) = delete;
@@ -79,13 +93,42 @@ public:
 
 	bool fullscreen() const;
 
+	/* Native by default. The virtual canvas is a fallback and only allocated when chosen. Set it before start */
+	inline void renderPath(RenderPath path) { _renderPath = path; }
+	inline RenderPath renderPath() const { return _renderPath; }
+
+	/*
+	 * The simulation runs on its own thread: objects get update and dispatchTimedEvent calls there,
+	 * and render calls on the render thread. They hand state to render through snapshots. The
+	 * window thread only polls events, stamping each one with the time it was received.
+	 */
+
+	/* Simulation ticks per second. Every object update receives exactly 1 / rate. Set it before start */
+	void tickRate(unsigned int rate);
+
+	/* Ticks run in a single frame at most. Time beyond that is dropped, so a stall slows the game down instead of freezing it */
+	inline void maxCatchUpTicks(unsigned int ticks) { _phMaxSteps = std::max(1U, ticks); }
+
+	inline unsigned int tickRate() const { return static_cast<unsigned int>(1000000 / _phStep.asMicroseconds()); }
+	inline sf::Time tickTime() const { return _phStep; }
+	inline UInt64 ticks() const { return _phTicks; }
+
+	/* Fraction of a tick that elapsed after the last simulated state, for rendering between two states */
+	inline float interpolation() const { return _phInterpolation; }
+
+	/* Hidden by default, toggled with default_control::profiler */
+	inline FrameProfiler& profiler() { return _profiler; }
+
 private:
 	void loop();
+	void simulate();
+	void present();
 
 	void init();
 	void update();
 	void render();
 	void processEvents();
+	void dispatchInputs(const sf::Time& tickStart, const sf::Time& tickEnd);
 
 protected:
 	virtual void onCreate(GameObject& element) override;
@@ -0,0 +1,31 @@
+#include "game_mode.h"
+
+
+GameMode global::mode;
+
+Json GameMode::_loadJson(const String& name) const
+{
+	Json json;
+
+	resource::modes.readJson(name + ".json", json);
+	return json;
+}
+
+void GameMode::_load(const String& name, const Json& json)
+{
+	CORE_TRACE_ZONE("GameMode::_load");
+
+	_name = utils::opt<String>(json, "name", name);
+	_level = utils::opt<unsigned int>(json, "level", 1);
+
+	_autoRepeatDelay = sf::microseconds(static_cast<sf::Int64>(utils::opt<double>(json, "das", core::ActionRepeatManager::auto_repeat_delay / 1000.0) * 1000.0));
+	_autoRepeatSpeed = sf::microseconds(static_cast<sf::Int64>(utils::opt<double>(json, "arr", core::ActionRepeatManager::auto_repeat_speed / 1000.0) * 1000.0));
+
+	_randomizer = core::RandomizerType::SevenBag;
+	if (utils::has(json, "randomizer"))
+	{
+		const String randomizer = utils::opt<String>(json, "randomizer", "");
+		if (!utils::randomizer_from_name(randomizer, _randomizer))
+			throw utils::JsonException{ "Unknown randomizer \"" + randomizer + "\" in game mode " + name + "." };
+	}
+}
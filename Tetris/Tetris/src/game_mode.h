@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.h"
+
+#include "core/randomizer.h"
+#include "core/scenario.h"
+
+
+class GameMode
+{
+private:
+	String _name;
+
+	core::RandomizerType _randomizer = core::RandomizerType::SevenBag;
+	unsigned int _level = 1;
+
+	sf::Time _autoRepeatDelay = sf::microseconds(core::ActionRepeatManager::auto_repeat_delay);
+	sf::Time _autoRepeatSpeed = sf::microseconds(core::ActionRepeatManager::auto_repeat_speed);
+
+public:
+	GameMode() = default;
+	GameMode(const GameMode&) = default;
+	GameMode(GameMode&&) noexcept = default;
+	~GameMode() = default;
+
+	GameMode& operator= (const GameMode&) = default;
+	GameMode& operator= (GameMode&&) noexcept = default;
+
+	inline const String& name() const { return _name; }
+
+	inline core::RandomizerType randomizer() const { return _randomizer; }
+
+	inline unsigned int level() const { return _level; }
+
+	/* DAS and ARR, "das" and "arr" in milliseconds. ARR 0 moves held pieces straight to the wall */
+	inline const sf::Time& autoRepeatDelay() const { return _autoRepeatDelay; }
+	inline const sf::Time& autoRepeatSpeed() const { return _autoRepeatSpeed; }
+
+private:
+	Json _loadJson(const String& name) const;
+	void _load(const String& name, const Json& json);
+
+public:
+	inline void load(const String& name) { _load(name, _loadJson(name)); }
+};
+
+namespace global
+{
+	extern GameMode mode;
+}
@@ -1,6 +1,7 @@
 #include "common.h"
 #include "game_controller.h"
 #include "theme.h"
+#include "game_mode.h"
 #include "scenario.h"
 #include "fonts.h"
 #include "audio.h"
@@ -10,7 +11,7 @@ struct Tester : public GameObject
 {
 	Scenario scenario;
 
-	Tester() : GameObject{} {};
+	Tester() : GameObject{}, scenario{ global::mode } {};
 
 	void render(sf::RenderTarget& canvas) override
 	{
@@ -24,12 +25,17 @@ struct Tester : public GameObject
 	{
 		scenario.dispatchEvent(event);
 	}
+	void dispatchTimedEvent(const sf::Event& event, const sf::Time& offset) override
+	{
+		scenario.dispatchEvent(event, offset);
+	}
 };
 
 
 int main(int argc, char** argv)
 {
 	global::theme.load("default");
+	global::mode.load("standard");
 	global::fonts.loadAll();
 	global::sounds.loadAll();
 	global::musics::prepareCache();
@@ -57,6 +63,7 @@ int main(int argc, char** argv)
 	tester.scenario.score().setPerimeterThickness(3);
 
 	global::game.videoMode({ 1600, 900 });
+	global::game.tickRate(240);
 	
 	global::game.start();
 
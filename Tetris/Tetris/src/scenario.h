@@ -5,197 +5,61 @@
 #include "theme.h"
 #include "fonts.h"
 #include "audio.h"
+#include "game_mode.h"
 
+#include "core/scenario.h"
+#include "core/triple_buffer.h"
 
-class Cell : private sf::RectangleShape
-{
-public:
-	static constexpr int width = 48;
-	static constexpr int height = 44;
-
-private:
-	CellColor _color;
-	int _row;
-	int _column;
-
-public:
-	Cell(const Cell&) = default;
-	Cell(Cell&&) noexcept = default;
-
-	Cell& operator= (const Cell&) = default;
-	Cell& operator= (Cell&&) noexcept = default;
-
-
-	Cell(CellColor color = CellColor::Empty);
 
-	void changeColor(CellColor color);
-
-	void ghostify();
-
-	void setPosition(int row, int column);
-
-	inline void render(sf::RenderTarget& canvas) const
-	{
-		if(_color != CellColor::Empty)
-			canvas.draw(*this);
-	}
-
-	inline CellColor color() const { return _color; }
-
-	inline bool empty() const { return _color == CellColor::Empty; }
-
-	inline operator bool() const { return _color != CellColor::Empty; }
-	inline bool operator! () const { return _color == CellColor::Empty; }
-
-	inline Cell(int row, int column, CellColor color = CellColor::Yellow) : Cell(color) { setPosition(row, column); }
-
-	inline int row() const { return _row; }
-	inline int column() const { return _column; }
-};
+using core::RotationState;
+using core::ScenarioAction;
 
 
 
-struct RotationState
+/* Size of a board cell in canvas pixels */
+struct Cell
 {
-	static constexpr int Origin = 0;
-	static constexpr int Right = 1;
-	static constexpr int Inverse = 2;
-	static constexpr int Left = 3;
-
-	int state;
-
-	constexpr RotationState() : state{ Origin } {}
-	constexpr RotationState(int state) : state{ utils::clamp(state, Origin, Left) } {}
-
-	inline bool isOrigin() { return state == Origin; }
-	inline bool isRight() { return state == Right; }
-	inline bool isInverse() { return state == Inverse; }
-	inline bool isLeft() { return state == Left; }
-
-	static constexpr RotationState origin() { return Origin; }
-	static constexpr RotationState right() { return Right; }
-	static constexpr RotationState inverse() { return Inverse; }
-	static constexpr RotationState left() { return Left; }
-
-	static constexpr bool isOrigin(RotationState state) { return state.state == Origin; }
-	static constexpr bool isRight(RotationState state) { return state.state == Right; }
-	static constexpr bool isInverse(RotationState state) { return state.state == Inverse; }
-	static constexpr bool isLeft(RotationState state) { return state.state == Left; }
+	static constexpr int width = 48;
+	static constexpr int height = 44;
 };
 
-constexpr RotationState& operator++ (RotationState& state)
-{
-	return (state.state = state.state == RotationState::Left ? RotationState::Origin : state.state + 1), state;
-}
-constexpr RotationState operator++ (RotationState& state, int)
-{
-	RotationState copy = state;
-	return ++state, copy;
-}
 
-constexpr RotationState& operator-- (RotationState& state)
-{
-	return (state.state = state.state == RotationState::Origin ? RotationState::Left : state.state - 1), state;
-}
-constexpr RotationState operator-- (RotationState& state, int)
-{
-	RotationState copy = state;
-	return --state, copy;
-}
 
-constexpr bool operator== (RotationState left, RotationState right) { return left.state == right.state; }
-constexpr bool operator!= (RotationState left, RotationState right) { return left.state != right.state; }
-
-
-
-struct TetrominoView;
-
-class Tetromino
+/* Cell quads sampling the theme cell atlas, so any amount of cells is a single draw call */
+class CellBatch
 {
-public:
-	enum class Type { I, O, T, J, L, S, Z };
-
-public:
-	static constexpr int rows = 4;
-	static constexpr int columns = 4;
-	static constexpr int type_count = static_cast<int>(Type::Z) + 1;
-
-	static constexpr int width = rows * Cell::width;
-	static constexpr int height = columns * Cell::height;
-
-	static constexpr int max_rotation_try = 5;
-
 private:
-	static constexpr int cellCount = rows * columns;
-
-private:
-	Cell _cells[cellCount];
-	int _row = 0;
-	int _column = 0;
-	Type _type = Type::I;
-	RotationState _rotation = RotationState::origin();
-
-	mutable int _idx[4] = {};
-	mutable bool _validIdx = false;
-
-	mutable Vec2i _vecs[4] = {};
-	mutable bool _validVecs = false;
+	sf::VertexArray _vertices;
 
 public:
-	Tetromino() = default;
-	Tetromino(const Tetromino&) = default;
-	Tetromino(Tetromino&&) noexcept = default;
-	~Tetromino() = default;
-
-	Tetromino& operator= (const Tetromino&) = default;
-	Tetromino& operator= (Tetromino&&) noexcept = default;
-
-	void render(sf::RenderTarget& canvas) const;
+	CellBatch();
+	CellBatch(const CellBatch&) = default;
+	CellBatch(CellBatch&&) noexcept = default;
+	~CellBatch() = default;
 
-	void build(Type type);
-	void build(const TetrominoView& view);
+	CellBatch& operator= (const CellBatch&) = default;
+	CellBatch& operator= (CellBatch&&) noexcept = default;
 
-	void ghostify();
+	void add(CellColor color, bool ghost, const sf::Transform& transform, const Vec2f& position, const Vec2f& size);
 
-	void setPosition(int row, int column);
+	void render(sf::RenderTarget& canvas, const sf::RenderStates& states = sf::RenderStates::Default) const;
 
-	void move(int rowDelta, int columnDelta);
-	void moveToOrigin();
+	/* Keeps the vertex storage, so a batch rebuilt every frame does not allocate */
+	inline void clear() { _vertices.clear(); }
 
-	void leftRotate();
-	void rightRotate();
-
-	void kick(RotationState prevState, unsigned int tryId);
-
-	std::array<int, 4> cellsIndex() const;
-	std::array<Vec2i, 4> cellsAsVector() const;
-
-	CellColor color() const;
-
-public:
-	inline void moveDown() { move(-1, 0); }
-	inline void moveLeft() { move(0, -1); }
-	inline void moveRight() { move(0, 1); }
-
-	inline int row() const { return _row; }
-	inline int column() const { return _column; }
-	inline Vec2i getPosition() const { return { _column, _row }; }
-
-	inline Type type() const { return _type; }
-
-	inline RotationState rotationState() const { return _rotation; }
-
-private:
-	static Vec2i _kickFactors(unsigned int tryId, Type type, RotationState rstate);
+	inline Size size() const { return _vertices.getVertexCount() / 4; }
 };
 
 
 
 struct TetrominoView
 {
-	static constexpr int cellCount = Tetromino::rows * Tetromino::columns;
+	static constexpr int cellCount = core::Tetromino::rows * core::Tetromino::columns;
+
+	static constexpr int width = core::Tetromino::columns * Cell::width;
+	static constexpr int height = core::Tetromino::rows * Cell::height;
 
-	Tetromino::Type type = Tetromino::Type::I;
+	core::Tetromino::Type type = core::Tetromino::Type::I;
 	CellColor cells[cellCount] = {};
 
 	TetrominoView() = default;
@@ -206,16 +70,11 @@ struct TetrominoView
 	TetrominoView& operator= (const TetrominoView&) = default;
 	TetrominoView& operator= (TetrominoView&&) noexcept = default;
 
-	void build(Tetromino::Type type);
+	void build(core::Tetromino::Type type);
 
-	void render(sf::RenderTarget& canvas, bool ghost, const Vec2f& position, const Vec2f& size = { static_cast<float>(Tetromino::width), static_cast<float>(Tetromino::height) });
+	void render(CellBatch& batch, bool ghost, const sf::Transform& transform, const Vec2f& position, const Vec2f& size = { static_cast<float>(TetrominoView::width), static_cast<float>(TetrominoView::height) }) const;
 
-	inline void render(sf::RenderTarget& canvas, bool ghost, float x, float y, float width, float height)
-	{
-		render(canvas, ghost, { x, y }, { width, height });
-	}
-
-	inline TetrominoView(Tetromino::Type type) : TetrominoView() { build(type); }
+	inline TetrominoView(core::Tetromino::Type type) : TetrominoView() { build(type); }
 };
 
 
@@ -223,20 +82,13 @@ struct TetrominoView
 class Field : public Frame
 {
 public:
-	static constexpr int rows = 22;
-	static constexpr int columns = 10;
-	static constexpr int visible_rows = rows - 2;
+	static constexpr int rows = core::Field::rows;
+	static constexpr int columns = core::Field::columns;
+	static constexpr int visible_rows = core::Field::visible_rows;
 
 	static constexpr int width = columns * Cell::width;
 	static constexpr int height = visible_rows * Cell::height;
 
-private:
-	static constexpr int cellCount = rows * columns;
-	static constexpr int visibleCellCount = visible_rows * columns;
-
-private:
-	Cell _cells[cellCount];
-
 public:
 	Field();
 	Field(const Field&) = default;
@@ -246,120 +98,19 @@ public:
 	Field& operator= (const Field&) = default;
 	Field& operator= (Field&&) noexcept = default;
 
-	void render(sf::RenderTarget& canvas, const Tetromino* tetromino = nullptr, const Tetromino* ghost = nullptr);
-	void update(const sf::Time& delta);
-
-	bool collide(const Tetromino& tetromino);
-	bool isTopOut(const Tetromino& tetromino);
-	bool isBottomOut(const Tetromino& tetromino);
-	bool isLeftOut(const Tetromino& tetromino);
-	bool isRightOut(const Tetromino& tetromino);
-	bool isInside(const Tetromino& tetromino);
-
-	void insert(const Tetromino& tetromino);
-
-	bool eraseIfComplete(int row);
+	/* Background and perimeter, the cells go through renderCells */
+	void render(sf::RenderTarget& canvas, const sf::RenderStates& states = sf::RenderStates::Default);
 
-	void dropRows(int bottomRow);
-
-	unsigned int TSlotCorners(const Tetromino& tetromino);
-
-	inline Cell& cell(int row, int column)
-	{
-		return _cells[utils::clamp(row, 0, rows - 1) * columns + utils::clamp(column, 0, columns - 1)];
-	}
-
-	inline const Cell& cell(int row, int column) const
-	{
-		return _cells[utils::clamp(row, 0, rows - 1) * columns + utils::clamp(column, 0, columns - 1)];
-	}
-
-	inline Cell& operator[] (const std::pair<int, int> location) { return cell(location.first, location.second); }
-	inline const Cell& operator[] (const std::pair<int, int> location) const { return cell(location.first, location.second); }
-};
-
-
-
-class GravityClock
-{
-private:
-	static constexpr Int64 min_waiting_time = static_cast<Int64>(0.05 / 60.0 * 1000000.0); // 20G //
-	static constexpr Int64 soft_drop_time = static_cast<Int64>(1.0 / 60.0 * 1000000.0); // 1G //
-	static constexpr Int64 freeze_time = static_cast<Int64>(0.5 * 1000000.0); // 0.5 seconds //
-	static constexpr Int64 insertion_time = static_cast<Int64>(0.5 * 1000000.0); // 0.5 seconds //
-	static constexpr Int64 insertion_with_erase_time = static_cast<Int64>(0.75 * 1000000.0); // 0.75 seconds //
-
-
-public:
-	enum class Mode { Normal, Soft, Hard };
+	/* Adds the visible cells, the tetromino and its ghost, placed where this panel is drawn */
+	void renderCells(CellBatch& batch, const core::Field& field, const core::Tetromino* tetromino = nullptr, const core::Tetromino* ghost = nullptr) const;
 
 private:
-	sf::Time _waiting;
-	sf::Time _remaining;
-	sf::Time _freezing;
-	sf::Time _inserting;
-	Mode _mode = Mode::Normal;
-
-public:
-	GravityClock() = default;
-	GravityClock(const GravityClock&) = default;
-	GravityClock(GravityClock&&) noexcept = default;
-	~GravityClock() = default;
-
-	GravityClock& operator= (const GravityClock&) = default;
-	GravityClock& operator= (GravityClock&&) noexcept = default;
-
-	void setGravityLevel(unsigned int level);
-
-	void updateWaiting(const sf::Time& delta);
-	void updateFreezing(const sf::Time& delta);
-	void updateInserting(const sf::Time& delta);
+	void _renderTetromino(CellBatch& batch, const sf::Transform& transform, const core::Tetromino& tetromino, bool ghost) const;
 
-	void registerDrop();
-
-	void resetWaiting();
-
-	void setMode(Mode mode);
-
-	inline void resetMode() { _mode = Mode::Normal; }
-	inline Mode mode() const { return _mode; }
-
-	inline void freeze() { _freezing = sf::microseconds(freeze_time); }
-	inline void insertion() { _inserting = sf::microseconds(insertion_time); }
-	inline void erasingInsertion() { _inserting = sf::microseconds(insertion_with_erase_time); }
-	inline void resetFreezing() { _freezing = sf::Time::Zero; }
-	inline void resetInserting() { _inserting = sf::Time::Zero; }
-	inline void reset() { resetMode(), resetWaiting(), resetFreezing(); }
-	
-	inline bool isFrozen() const { return _freezing > sf::Time::Zero; }
-	inline bool isWaiting() const
+	static inline Vec2f _cellPosition(int row, int column)
 	{
-		return _mode != Mode::Hard && _remaining > sf::Time::Zero;
+		return { static_cast<float>(column * Cell::width), static_cast<float>((visible_rows - 1 - row) * Cell::height) };
 	}
-	inline bool isInserting() const { return _inserting > sf::Time::Zero; }
-};
-
-
-
-class TetrominoBag
-{
-private:
-	Tetromino::Type _bag[Tetromino::type_count] = {};
-	unsigned int _remaining = 0;
-
-public:
-	TetrominoBag() = default;
-	TetrominoBag(const TetrominoBag&) = default;
-	TetrominoBag(TetrominoBag&&) noexcept = default;
-	~TetrominoBag() = default;
-
-	TetrominoBag& operator= (const TetrominoBag&) = default;
-	TetrominoBag& operator= (TetrominoBag&&) noexcept = default;
-
-	Tetromino::Type take();
-
-private:
-	void _generate();
 };
 
 
@@ -367,14 +118,10 @@ private:
 class TetrominoManager : public Frame
 {
 public:
-	static constexpr int next_count = 5;
+	static constexpr int next_count = core::TetrominoManager::next_count;
 
-	static constexpr int width = static_cast<int>(Tetromino::width * 0.6);
-	static constexpr int height = static_cast<int>(Tetromino::height * TetrominoManager::next_count * 0.6);
-
-private:
-	TetrominoBag _bag;
-	std::list<TetrominoView> _next;
+	static constexpr int width = static_cast<int>(TetrominoView::width * 0.6);
+	static constexpr int height = static_cast<int>(TetrominoView::height * TetrominoManager::next_count * 0.6);
 
 public:
 	TetrominoManager();
@@ -385,12 +132,9 @@ public:
 	TetrominoManager& operator= (const TetrominoManager&) = default;
 	TetrominoManager& operator= (TetrominoManager&&) noexcept = default;
 
-	Tetromino next();
-
-	void render(sf::RenderTarget& canvas);
+	void render(sf::RenderTarget& canvas, const sf::RenderStates& states = sf::RenderStates::Default);
 
-private:
-	void generate();
+	void renderCells(CellBatch& batch, const core::Tetromino::Type* types, unsigned int count) const;
 };
 
 
@@ -398,13 +142,8 @@ private:
 class HoldManager : public Frame
 {
 public:
-	static constexpr int width = static_cast<int>(Tetromino::width * 0.6);
-	static constexpr int height = static_cast<int>(Tetromino::height * 0.6);
-
-private:
-	TetrominoView _tetromino;
-	bool _empty;
-	bool _lock;
+	static constexpr int width = static_cast<int>(TetrominoView::width * 0.6);
+	static constexpr int height = static_cast<int>(TetrominoView::height * 0.6);
 
 public:
 	HoldManager();
@@ -415,68 +154,9 @@ public:
 	HoldManager& operator= (const HoldManager&) = default;
 	HoldManager& operator= (HoldManager&&) noexcept = default;
 
-	void render(sf::RenderTarget& canvas);
+	void render(sf::RenderTarget& canvas, const sf::RenderStates& states = sf::RenderStates::Default);
 
-	void hold(Tetromino::Type type);
-
-	inline bool empty() const { return _empty; }
-
-	inline void hold(const Tetromino& tetromino) { hold(tetromino.type()); }
-
-	inline const TetrominoView& tetromino() const { return _tetromino; }
-
-	inline bool isLock() { return _lock; }
-
-	inline void unlock() { _lock = false; }
-};
-
-
-
-enum class ScenarioAction
-{
-	None,
-	MoveLeft,
-	MoveRight,
-	RotateLeft,
-	RotateRight,
-	NormalDrop,
-	SoftDrop,
-	HardDrop,
-	Hold
-};
-
-
-
-class ActionRepeatManager
-{
-public:
-	static constexpr Int64 auto_repeat_delay = static_cast<Int64>(170 * 1000); /* 170 milliseconds */
-	static constexpr Int64 auto_repeat_speed = static_cast<Int64>(50 * 1000); /* 50 milliseconds */
-
-private:
-	sf::Time _delay;
-	sf::Time _speed;
-	ScenarioAction _action = ScenarioAction::None;
-
-public:
-	ActionRepeatManager() = default;
-	ActionRepeatManager(const ActionRepeatManager&) = default;
-	ActionRepeatManager(ActionRepeatManager&&) noexcept = default;
-	~ActionRepeatManager() = default;
-
-	ActionRepeatManager& operator= (const ActionRepeatManager&) = default;
-	ActionRepeatManager& operator= (ActionRepeatManager&&) noexcept = default;
-
-	void update(const sf::Time& delta);
-
-	void registerAction(ScenarioAction action);
-
-	inline void releaseAction() { registerAction(ScenarioAction::None); }
-
-	inline bool isRepeating() const { return _action != ScenarioAction::None && _delay <= sf::Time::Zero; }
-	inline bool isWaiting() const { return _action == ScenarioAction::None || _speed > sf::Time::Zero; }
-	inline void registerRepeat() { _speed += sf::microseconds(auto_repeat_speed); }
-	inline ScenarioAction action() const { return _action; }
+	void renderCells(CellBatch& batch, const core::HoldManager& hold) const;
 };
 
 
@@ -492,6 +172,7 @@ public:
 
 private:
 	UInt64 _points;
+	double _pointsCarry;
 	UInt64 _lines;
 	unsigned int _level;
 
@@ -499,10 +180,6 @@ private:
 	sf::Text _tLines;
 	sf::Text _tLevel;
 
-	UInt64 _remainingPoints;
-
-	bool _backToBack;
-
 	Font* _font;
 
 public:
@@ -514,72 +191,22 @@ public:
 	Score& operator= (const Score&) = default;
 	Score& operator= (Score&&) noexcept = default;
 
-	void render(sf::RenderTarget& canvas);
+	void render(sf::RenderTarget& canvas, const sf::RenderStates& states = sf::RenderStates::Default);
 
-	void update(const sf::Time& delta);
-
-	void addLines(UInt64 amount);
-
-	void setLevel(unsigned int level);
+	/* Shown points count up towards the score points, the rest of values are just copied */
+	void update(const sf::Time& delta, const core::Score& score);
 
 	inline UInt64 points() const { return _points; }
 	inline UInt64 lines() const { return _lines; }
 	inline unsigned int level() const { return _level; }
-	inline bool hasBackToBack() const { return _backToBack; }
-
-	inline void addSingleScore() { _increasePointsFromBase(100, false); }
-	inline void addDoubleScore() { _increasePointsFromBase(300, false); }
-	inline void addTripleScore() { _increasePointsFromBase(500, false); }
-	inline void addTetrisScore() { _increasePointsFromBase(800, true); }
-
-	inline void addTSpinMiniNoLinesScore() { _increasePointsFromBase(100, false); }
-	inline void addTSpinMiniSingleScore() { _increasePointsFromBase(200, true); }
-	inline void addTSpinMiniDoubleScore() { _increasePointsFromBase(400, true); }
-
-	inline void addTSpinNoLinesScore() { _increasePointsFromBase(400, false); }
-	inline void addTSpinSingleScore() { _increasePointsFromBase(400, true); }
-	inline void addTSpinDoubleScore() { _increasePointsFromBase(1200, true); }
-	inline void addTSpinTripleScore() { _increasePointsFromBase(1600, true); }
-
-	inline void addSoftDropScore() { _increasePoints(1); }
-	inline void addHardDropScore() { _increasePoints(2); }
 
 private:
-	void _increasePoints(UInt64 amount);
-	void _increasePointsFromBase(int base, bool difficult);
-
 	void _updatePointsText();
 	void _updateLinesText();
 	void _updateLevelText();
 };
 
 
-struct TetrominoScenarioInfo
-{
-public:
-	enum class MoveType { Drop, Horizontal, Rotate };
-
-public:
-	MoveType lastMove = MoveType::Drop;
-	Tetromino::Type type = Tetromino::Type::I;
-	RotationState rotation;
-	unsigned int kicks = 0;
-
-	TetrominoScenarioInfo() = default;
-	TetrominoScenarioInfo(const TetrominoScenarioInfo&) = default;
-	TetrominoScenarioInfo(TetrominoScenarioInfo&&) noexcept = default;
-	~TetrominoScenarioInfo() = default;
-
-	TetrominoScenarioInfo& operator= (const TetrominoScenarioInfo&) = default;
-	TetrominoScenarioInfo& operator= (TetrominoScenarioInfo&&) noexcept = default;
-
-	void set(const Tetromino& tetromino, MoveType moveType = MoveType::Drop);
-	void registerDrop();
-	void registerHorizontal();
-	void registerRotate(RotationState rotation, unsigned int kicks);
-};
-
-
 
 class Scenario : public Frame
 {
@@ -591,39 +218,33 @@ public:
 	static constexpr int height = Field::height + Score::height;
 
 public:
-	enum class State { Running, GameOver };
-	
+	using State = core::Scenario::State;
 
 private:
-	enum class TetrominoState { None, Dropping, Frozen, Inserting };
-	enum class MoveType { Drop, Horizontal, Rotate };
 	enum class PauseState { None, Paused, Resuming };
 	using Action = ScenarioAction;
 
+	/* What the render thread draws, published by the simulation after every update */
+	struct Snapshot
+	{
+		core::ScenarioSnapshot game;
+		PauseState pause = PauseState::None;
+		int countdown = 0;
+
+		inline bool sameView(const Snapshot& other) const { return pause == other.pause && countdown == other.countdown && game.sameView(other.game); }
+	};
+
 private:
-	Field _field;
+	core::Scenario _game;
+	core::TripleBuffer<Snapshot> _snapshots;
+	Snapshot _lastSnapshot;
+	bool _published;
 
+	Field _field;
 	HoldManager _hold;
 	TetrominoManager _nextTetrominos;
-	Tetromino _currentTetromino;
-	Tetromino _ghostTetromino;
-	TetrominoState _currentTetrominoState;
-
-	int _bottomRowToErase;
-
-	unsigned int _linesPerLevel;
-	unsigned int _currentLevel;
-
-	TetrominoScenarioInfo _tetrominoInfo;
-
-	ActionRepeatManager _horizontalMoveRepeat;
-
-	GravityClock _gravity;
-
 	Score _score;
 
-	State _state;
-
 	bool _pauseButton;
 	PauseState _pause;
 	sf::Text _pauseText;
@@ -631,65 +252,51 @@ private:
 
 	SoundController _sounds;
 
-	std::queue<ScenarioAction> _actionQueue;
+	sf::Clock _renderClock;
+	CellBatch _cells;
 
 public:
 	Scenario();
+	explicit Scenario(const GameMode& mode);
 	Scenario(const Scenario&) = delete;
-	Scenario(Scenario&&) noexcept = default;
+	Scenario(Scenario&&) noexcept = delete;
 	~Scenario() = default;
 
 	Scenario& operator= (const Scenario&) = delete;
-	Scenario& operator= (Scenario&&) noexcept = default;
+	Scenario& operator= (Scenario&&) noexcept = delete;
 
-	inline State state() const { return _state; }
+	inline State state() const { return _game.state(); }
+
+	inline const core::Scenario& game() const { return _game; }
 
 	inline Field& field() { return _field; }
 	inline TetrominoManager& nextTetrominoManager() { return _nextTetrominos; }
 	inline HoldManager& holdManager() { return _hold; }
 	inline Score& score() { return _score; }
 
-	inline void setLevel(unsigned int level) { _gravity.setGravityLevel(level); }
+	inline void setLevel(unsigned int level) { _game.setLevel(level); }
 
-	inline void pushAction(ScenarioAction action) { _actionQueue.push(action); }
+	inline void pushAction(ScenarioAction action) { _game.pushAction(action); }
 
 public:
-	void render(sf::RenderTarget& canvas);
+	/* Render thread. Draws the latest published snapshot. When cached, the canvas is redrawn only when it changed */
+	void render(sf::RenderTarget& canvas, const sf::RenderStates& states = sf::RenderStates::Default);
 
+	/* Simulation thread, like dispatchEvent */
 	void update(const sf::Time& delta);
 
-	void dispatchEvent(const sf::Event& event);
+	/* offset is how far into the next update the event happened */
+	void dispatchEvent(const sf::Event& event, const sf::Time& offset = sf::Time::Zero);
 
 private:
-	void _updateActions(const sf::Time& delta);
-	void _updateCurrentTetromino(const sf::Time& delta);
-
-	void _spawnTetromino(bool useHold);
-	void _dropCurrentTetromino();
-	void _horizontalMoveTetromino(bool left);
-	void _rotateCurrentTetromino(bool left);
-	void _holdTetromino();
-
-	void _evaluateTetrominoStateAfterAction();
-
-	void _generateGhostTetromino();
-
-	void _insertTetromino();
-
-	unsigned int _eraseCompleteLines();
-
-	void _checkLevel();
+	void _playEventSounds();
 
 	void _setPause(bool paused);
 
-	void _clearActionsQueue();
+	void _publish();
 
-private:
-	inline void _moveLeftTetromino() { _horizontalMoveTetromino(true); }
-	inline void _moveRightTetromino() { _horizontalMoveTetromino(false); }
-
-	inline void _rotateLeftCurrentTetromino() { _rotateCurrentTetromino(true); }
-	inline void _rotateRightCurrentTetromino() { _rotateCurrentTetromino(false); }
+	void _updatePauseText(const Snapshot& snapshot);
 
+private:
 	inline void _playSound(const char* sound) { _sounds.play(sound); }
 };
@@ -1,5 +1,7 @@
 #include "theme.h"
 
+#include <map>
+
 
 Theme global::theme;
 
@@ -20,34 +22,25 @@ Music& Theme::loadScenarioMusic(Music& music)
 
 
 
-Path Theme::_getPath(const String& filename)
-{
-	return Path{ _folderName } / filename;
-}
-
 resource::Folder Theme::_getFolder() const
 {
 	return resource::themes.folder(_folderName);
 }
 
-Texture& Theme::_loadTexture(const TextureInfo& textureInfo, const String& name)
-{
-	TextureInfo info = textureInfo;
-	info.name = name;
-	info.file = _getPath(info.file).string();
-	return _textures.load(info);
-}
-
 void Theme::_load(const String& name, const Json& json)
 {
+	CORE_TRACE_ZONE("Theme::_load");
+
 	_folderName = name;
 
 	if (utils::has(json, "name"))
 		_name = utils::opt<String>(json, "name", name);
 	else _name = name;
 
-	_loadCellColors(json, false);
-	_loadCellColors(json, true);
+	std::vector<CellSource> cellSources;
+	_loadCellColors(json, false, cellSources);
+	_loadCellColors(json, true, cellSources);
+	_buildCellAtlas(cellSources);
 
 	_loadScenarioMusic(json);
 }
@@ -61,7 +54,7 @@ Json Theme::_loadJson(const String& name) const
 	return json;
 }
 
-void Theme::_loadCellColors(const Json& json, bool ghost)
+void Theme::_loadCellColors(const Json& json, bool ghost, std::vector<CellSource>& sources)
 {
 	const char* const obj_name = ghost ? "ghost_colors" : "cell_colors";
 
@@ -81,20 +74,74 @@ void Theme::_loadCellColors(const Json& json, bool ghost)
 		{ "blue", 5 },
 		{ "purple", 6 },
 		{ "gray", 7 }
-	});
+	}, sources);
 }
 
-void Theme::_loadCellColors(const Json& json, bool ghost, const std::vector<std::pair<const char*, Offset>>& ids)
+void Theme::_loadCellColors(const Json& json, bool ghost, const std::vector<std::pair<const char*, Offset>>& ids, std::vector<CellSource>& sources)
 {
-	sf::Texture** colors = ghost ? _ghostColors : _cellColors;
-	String name_prefix = ghost ? "cell.ghost." : "cell.";
+	IntRect* colors = ghost ? _ghostColors : _cellColors;
 	for (const auto& id : ids)
 	{
-		if (!utils::has(json, id.first))
-			continue;
+		colors[id.second] = {};
+		if (utils::has(json, id.first))
+			sources.push_back({ TextureInfo::read(json[id.first]), &colors[id.second] });
+	}
+}
+
+void Theme::_buildCellAtlas(const std::vector<CellSource>& sources)
+{
+	CORE_TRACE_ZONE("Theme::_buildCellAtlas");
+
+	if (sources.empty())
+		return;
+
+	/* Each source image is decoded once, however many colors it holds */
+	const resource::Folder folder = _getFolder();
+	std::map<String, sf::Image> images;
+
+	std::vector<IntRect> areas;
+	areas.reserve(sources.size());
+
+	Vec2u slot;
+	for (const CellSource& source : sources)
+	{
+		auto it = images.find(source.info.file);
+		if (it == images.end())
+		{
+			it = images.emplace(source.info.file, sf::Image{}).first;
+			if (!it->second.loadFromFile(folder.pathOf(source.info.file).string()))
+				throw std::exception{ "An error has been ocurred during texture load." };
+		}
+
+		/* Same rules as Texture::loadFromFile: an empty area is the whole image */
+		const Vec2u imageSize = it->second.getSize();
+		IntRect area{ static_cast<int>(source.info.x), static_cast<int>(source.info.y), static_cast<int>(source.info.width), static_cast<int>(source.info.height) };
+		if (area.width <= 0 || area.height <= 0)
+			area = { 0, 0, static_cast<int>(imageSize.x), static_cast<int>(imageSize.y) };
+
+		areas.push_back(area);
+		slot = { std::max(slot.x, static_cast<unsigned int>(area.width)), std::max(slot.y, static_cast<unsigned int>(area.height)) };
+	}
+
+	/* One slot per source, as many per row as needed to stay about square */
+	const unsigned int count = static_cast<unsigned int>(sources.size());
+	unsigned int perRow = 1;
+	while (perRow * perRow < count)
+		perRow++;
+
+	sf::Image atlas;
+	atlas.create(slot.x * perRow, slot.y * ((count + perRow - 1) / perRow), sf::Color::Transparent);
 
-		colors[id.second] = &_loadTexture(TextureInfo::read(json[id.first]), name_prefix + id.first);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const IntRect& area = areas[i];
+		const unsigned int x = slot.x * (i % perRow), y = slot.y * (i / perRow);
+
+		atlas.copy(images[sources[i].info.file], x, y, area);
+		*sources[i].area = { static_cast<int>(x), static_cast<int>(y), area.width, area.height };
 	}
+
+	_cellAtlas.loadFromImage(atlas);
 }
 
 void Theme::_loadScenarioMusic(const Json& json)
@@ -5,29 +5,7 @@
 #include "audio.h"
 
 
-enum class CellColor
-{
-	Empty,
-	Red,
-	Orange,
-	Yellow,
-	Green,
-	Cyan,
-	Blue,
-	Purple,
-	Gray
-};
-
-namespace utils
-{
-	constexpr Size cell_color_count = static_cast<Size>(CellColor::Gray) + 1;
-
-	constexpr Offset cellcolor_id(CellColor color) { return static_cast<Offset>(color); }
-
-	constexpr CellColor id_to_cellcolor(Offset id) { return static_cast<CellColor>(utils::clamp<Offset, Offset, Offset>(id, 0, cell_color_count - 1)); }
-
-	constexpr CellColor id_to_noempty_cellcolor(Offset id) { return static_cast<CellColor>(utils::clamp<Offset, Offset, Offset>(id, 1, cell_color_count - 1)); }
-}
+using core::CellColor;
 
 class Theme
 {
@@ -39,14 +17,20 @@ private:
 		MusicInfo info;
 	};
 
-private:
-	TextureManager _textures = global::textures.createChild(resource::themes);
+	struct CellSource
+	{
+		TextureInfo info;
+		IntRect* area;
+	};
 
+private:
 	String _folderName;
 	String _name;
 
-	Texture* _cellColors[utils::cell_color_count - 1] = {};
-	Texture* _ghostColors[utils::cell_color_count - 1] = {};
+	/* Every cell and ghost color packed in one texture, so boards draw all their cells in a single call */
+	Texture _cellAtlas;
+	IntRect _cellColors[utils::cell_color_count - 1] = {};
+	IntRect _ghostColors[utils::cell_color_count - 1] = {};
 
 	MusicData _scenarioMusic;
 
@@ -61,19 +45,21 @@ public:
 
 	Music& loadScenarioMusic(Music& music);
 
-	inline const Texture* cellColorTexture(CellColor cell) { return cell == CellColor::Empty ? nullptr : _cellColors[utils::cellcolor_id(cell) - 1]; }
-	inline const Texture* ghostColorTexture(CellColor cell) { return cell == CellColor::Empty ? nullptr : _ghostColors[utils::cellcolor_id(cell) - 1]; }
+	inline const Texture& cellAtlas() const { return _cellAtlas; }
+
+	/* Areas inside cellAtlas, empty for CellColor::Empty and colors the theme does not define */
+	inline IntRect cellColorTexture(CellColor cell) const { return cell == CellColor::Empty ? IntRect{} : _cellColors[utils::cellcolor_id(cell) - 1]; }
+	inline IntRect ghostColorTexture(CellColor cell) const { return cell == CellColor::Empty ? IntRect{} : _ghostColors[utils::cellcolor_id(cell) - 1]; }
 
 private:
-	Path _getPath(const String& filename);
 	resource::Folder _getFolder() const;
-	Texture& _loadTexture(const TextureInfo& textureInfo, const String& name);
 
 	Json _loadJson(const String& name) const;
 	void _load(const String& name, const Json& json);
 
-	void _loadCellColors(const Json& json, bool ghost);
-	void _loadCellColors(const Json& json, bool ghost, const std::vector<std::pair<const char*, Offset>>& ids);
+	void _loadCellColors(const Json& json, bool ghost, std::vector<CellSource>& sources);
+	void _loadCellColors(const Json& json, bool ghost, const std::vector<std::pair<const char*, Offset>>& ids, std::vector<CellSource>& sources);
+	void _buildCellAtlas(const std::vector<CellSource>& sources);
 
 	void _loadScenarioMusic(const Json& json);
 
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <chrono>
+#include <array>
+
+
+typedef std::uint8_t UInt8;
+typedef std::uint16_t UInt16;
+typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
+
+typedef std::int8_t Int8;
+typedef std::int16_t Int16;
+typedef std::int32_t Int32;
+typedef std::int64_t Int64;
+
+typedef std::size_t Size;
+typedef std::size_t Offset;
+
+
+namespace utils
+{
+	template<typename _ValueTy, typename _MinTy, typename _MaxTy>
+	constexpr _ValueTy clamp(_ValueTy value, _MinTy min, _MaxTy max)
+	{
+		if constexpr (std::same_as< _MinTy, _ValueTy>)
+		{
+			if constexpr (std::same_as< _MaxTy, _ValueTy>)
+				return std::max(std::min(max, value), min);
+			else return std::max(std::min(static_cast<_ValueTy>(max), value), min);
+		}
+		else
+		{
+			if constexpr (std::same_as< _MaxTy, _ValueTy>)
+				return std::max(std::min(max, value), static_cast<_ValueTy>(min));
+			else return std::max(std::min(static_cast<_ValueTy>(max), value), static_cast<_ValueTy>(min));
+		}
+	}
+}
+
+
+
+/*
+ * Game rules core. Everything inside the core namespace only depends on the
+ * standard library, so it can be built and run without a window, fonts or textures.
+ */
+namespace core
+{
+	typedef std::chrono::microseconds Time;
+
+	struct Point
+	{
+		int x = 0;
+		int y = 0;
+
+		constexpr Point() = default;
+		constexpr Point(int x, int y) : x{ x }, y{ y } {}
+
+		constexpr bool operator== (const Point&) const = default;
+
+		constexpr Point operator+ (const Point& right) const { return { x + right.x, y + right.y }; }
+		constexpr Point operator- (const Point& right) const { return { x - right.x, y - right.y }; }
+	};
+
+
+
+	enum class CellColor : UInt8
+	{
+		Empty,
+		Red,
+		Orange,
+		Yellow,
+		Green,
+		Cyan,
+		Blue,
+		Purple,
+		Gray
+	};
+}
+
+namespace utils
+{
+	constexpr Size cell_color_count = static_cast<Size>(core::CellColor::Gray) + 1;
+
+	constexpr Offset cellcolor_id(core::CellColor color) { return static_cast<Offset>(color); }
+
+	constexpr core::CellColor id_to_cellcolor(Offset id) { return static_cast<core::CellColor>(utils::clamp<Offset, Offset, Offset>(id, 0, cell_color_count - 1)); }
+
+	constexpr core::CellColor id_to_noempty_cellcolor(Offset id) { return static_cast<core::CellColor>(utils::clamp<Offset, Offset, Offset>(id, 1, cell_color_count - 1)); }
+}
@@ -0,0 +1,213 @@
+#include "beam_search.h"
+#include "trace.h"
+
+
+namespace core
+{
+	BeamSearch::BeamSearch(const BotEvaluator& evaluator, unsigned int width, unsigned int previews, unsigned int threads) :
+		_evaluator{ evaluator },
+		_width{ std::max(1U, width) },
+		_previews{ std::min(previews, static_cast<unsigned int>(TetrominoManager::next_count)) },
+		_pool{ threads },
+		_workers{},
+		_beam{},
+		_children{},
+		_roots{},
+		_rootInputs{},
+		_queue{},
+		_queueSize{ 0 },
+		_decision{},
+		_statistics{}
+	{
+		_workers.resize(_pool.size());
+	}
+
+	const BeamDecision& BeamSearch::search(const Scenario& scenario)
+	{
+		BotBoard board;
+		board.field = scenario.field();
+		board.backToBack = scenario.score().hasBackToBack();
+
+		return search(board, scenario.currentTetromino(), scenario.holdManager(), scenario.nextTetrominoManager().queue());
+	}
+
+	const BeamDecision& BeamSearch::search(const BotBoard& board, const Tetromino& current, const HoldManager& hold, const std::deque<Tetromino::Type>& queue)
+	{
+		CORE_TRACE_ZONE("BeamSearch::search");
+
+		const auto start = std::chrono::steady_clock::now();
+
+		_queueSize = 0;
+		for (Tetromino::Type type : queue)
+			if (_queueSize < TetrominoManager::next_count)
+				_queue[_queueSize++] = type;
+
+		for (auto& worker : _workers)
+			worker.nodes = 0;
+
+		_expandRoot(board, current, hold);
+		_selectBeam();
+
+		const WorkStealingPool::Task expand = [this](unsigned int index, unsigned int worker) { _expand(index, worker); };
+		for (unsigned int level = 0; level < _previews && !_beam.empty(); level++)
+		{
+			for (auto& worker : _workers)
+				worker.arena.clear();
+
+			_pool.parallelFor(static_cast<unsigned int>(_beam.size()), expand);
+
+			/* Workers are merged in a fixed order, the ranking does the rest */
+			_children.clear();
+			for (auto& worker : _workers)
+				_children.insert(_children.end(), worker.arena.begin(), worker.arena.end());
+
+			/* Keep the last beam if every line of play tops out */
+			if (_children.empty())
+				break;
+			_selectBeam();
+		}
+
+		_decision = {};
+		if (!_beam.empty())
+		{
+			const RootMove& root = _roots[_beam.front().root];
+			_decision.hold = root.hold;
+			_decision.inputs.assign(_rootInputs.begin() + root.firstInput, _rootInputs.begin() + root.firstInput + root.inputCount);
+			_decision.value = _beam.front().value;
+		}
+
+		for (const auto& worker : _workers)
+			_statistics.nodes += worker.nodes;
+		_statistics.elapsed += std::chrono::duration_cast<Time>(std::chrono::steady_clock::now() - start);
+
+		return _decision;
+	}
+
+	std::vector<BeamScaling> BeamSearch::measureScaling(const Scenario& scenario, const BotEvaluator& evaluator, unsigned int width, unsigned int previews, unsigned int maxThreads, unsigned int repeats)
+	{
+		std::vector<BeamScaling> results;
+		for (unsigned int threads = 1; threads <= std::max(1U, maxThreads); threads++)
+		{
+			BeamSearch search{ evaluator, width, previews, threads };
+			for (unsigned int i = 0; i < std::max(1U, repeats); i++)
+				search.search(scenario);
+
+			BeamScaling scaling;
+			scaling.threads = threads;
+			scaling.nodesPerSecond = search.statistics().nodesPerSecond();
+			scaling.efficiency = results.empty() || results.front().nodesPerSecond <= 0.0
+				? 1.0
+				: scaling.nodesPerSecond / results.front().nodesPerSecond / static_cast<double>(threads);
+			results.push_back(scaling);
+		}
+		return results;
+	}
+
+	void BeamSearch::_expandRoot(const BotBoard& board, const Tetromino& current, const HoldManager& hold)
+	{
+		Worker& worker = _workers.front();
+		worker.arena.clear();
+		_roots.clear();
+		_rootInputs.clear();
+
+		Node root;
+		root.board = board;
+		root.reward = 0.0;
+		root.value = 0.0;
+		root.hold = hold.type();
+		root.hasHold = !hold.empty();
+		root.queueIndex = 0;
+		root.root = 0;
+		root.parent = 0;
+		root.option = 0;
+		root.placement = 0;
+
+		const auto addRoots = [&](const std::vector<Placement>& placements, UInt16 option, bool hasHold, Tetromino::Type held, unsigned int queueIndex)
+		{
+			const Size first = worker.arena.size();
+			_addChildren(worker, root, 0, option, placements, hasHold, held, queueIndex);
+
+			for (Size i = first; i < worker.arena.size(); i++)
+			{
+				const auto inputs = worker.generator.inputs(placements[worker.arena[i].placement]);
+				worker.arena[i].root = static_cast<UInt16>(_roots.size());
+				_roots.push_back({ option != 0, static_cast<unsigned int>(_rootInputs.size()), static_cast<unsigned int>(inputs.size()) });
+				_rootInputs.insert(_rootInputs.end(), inputs.begin(), inputs.end());
+			}
+		};
+
+		addRoots(worker.generator.generate(board.field, current), 0, root.hasHold, root.hold, 0);
+
+		if (!hold.isLock())
+		{
+			if (root.hasHold)
+				addRoots(worker.generator.generate(board.field, root.hold), 1, true, current.type(), 0);
+			else if (_queueSize > 0)
+				addRoots(worker.generator.generate(board.field, _queue[0]), 1, true, current.type(), 1);
+		}
+
+		_children.assign(worker.arena.begin(), worker.arena.end());
+	}
+
+	void BeamSearch::_expand(unsigned int index, unsigned int worker)
+	{
+		CORE_TRACE_ZONE("BeamSearch::_expand");
+
+		Worker& self = _workers[worker];
+		const Node& parent = _beam[index];
+
+		if (parent.queueIndex >= _queueSize)
+			return;
+
+		const Tetromino::Type piece = _queue[parent.queueIndex];
+		_addChildren(self, parent, index, 0, self.generator.generate(parent.board.field, piece), parent.hasHold, parent.hold, parent.queueIndex + 1);
+
+		if (parent.hasHold)
+		{
+			if (parent.hold != piece)
+				_addChildren(self, parent, index, 1, self.generator.generate(parent.board.field, parent.hold), true, piece, parent.queueIndex + 1);
+		}
+		else if (parent.queueIndex + 1U < _queueSize)
+			_addChildren(self, parent, index, 1, self.generator.generate(parent.board.field, _queue[parent.queueIndex + 1]), true, piece, parent.queueIndex + 2);
+	}
+
+	void BeamSearch::_addChildren(Worker& worker, const Node& parent, UInt32 parentIndex, UInt16 option, const std::vector<Placement>& placements, bool hasHold, Tetromino::Type hold, unsigned int queueIndex)
+	{
+		for (Size i = 0; i < placements.size(); i++)
+		{
+			Node& child = worker.arena.emplace_back();
+			child.reward = parent.reward + _evaluator.place(parent.board, placements[i], child.board);
+			child.value = child.reward + _evaluator.evaluate(child.board.field);
+			child.hold = hold;
+			child.hasHold = hasHold;
+			child.queueIndex = static_cast<UInt8>(queueIndex);
+			child.root = parent.root;
+			child.parent = parentIndex;
+			child.option = option;
+			child.placement = static_cast<UInt16>(i);
+		}
+		worker.nodes += placements.size();
+	}
+
+	void BeamSearch::_selectBeam()
+	{
+		if (_children.size() > _width)
+		{
+			std::nth_element(_children.begin(), _children.begin() + _width, _children.end(), &BeamSearch::_better);
+			_children.resize(_width);
+		}
+		std::sort(_children.begin(), _children.end(), &BeamSearch::_better);
+		_beam.swap(_children);
+	}
+
+	bool BeamSearch::_better(const Node& left, const Node& right)
+	{
+		if (left.value != right.value)
+			return left.value > right.value;
+		if (left.parent != right.parent)
+			return left.parent < right.parent;
+		if (left.option != right.option)
+			return left.option < right.option;
+		return left.placement < right.placement;
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "bot.h"
+#include "thread_pool.h"
+
+
+namespace core
+{
+	/* Result of the search: what to do with the current piece */
+	struct BeamDecision
+	{
+		bool hold = false;
+		std::vector<ScenarioAction> inputs;
+		double value = 0.0;
+	};
+
+	/* Speed of the search running with a given thread count */
+	struct BeamScaling
+	{
+		unsigned int threads = 0;
+		double nodesPerSecond = 0.0;
+
+		/* Speed up over one thread, divided by the thread count */
+		double efficiency = 0.0;
+	};
+
+
+
+	/*
+	 * Beam search over the current piece and the next queue, with hold swaps at every level.
+	 * Each level is expanded in parallel, every worker generating moves and children into its
+	 * own arena. Children are ranked by value and then by their position in the parent beam,
+	 * so the decision is the same for any thread count.
+	 */
+	class BeamSearch
+	{
+	public:
+		struct Statistics
+		{
+			UInt64 nodes = 0;
+			Time elapsed = Time::zero();
+
+			inline double nodesPerSecond() const
+			{
+				return elapsed > Time::zero() ? static_cast<double>(nodes) * 1000000.0 / static_cast<double>(elapsed.count()) : 0.0;
+			}
+		};
+
+	private:
+		struct Node
+		{
+			BotBoard board;
+			double reward;
+			double value;
+
+			Tetromino::Type hold;
+			bool hasHold;
+			UInt8 queueIndex;
+
+			UInt16 root;
+			UInt32 parent;
+			UInt16 option;
+			UInt16 placement;
+		};
+
+		struct RootMove
+		{
+			bool hold;
+			unsigned int firstInput;
+			unsigned int inputCount;
+		};
+
+		struct Worker
+		{
+			MoveGenerator generator;
+			std::vector<Node> arena;
+			UInt64 nodes = 0;
+		};
+
+	private:
+		BotEvaluator _evaluator;
+		unsigned int _width;
+		unsigned int _previews;
+
+		WorkStealingPool _pool;
+		std::vector<Worker> _workers;
+
+		std::vector<Node> _beam;
+		std::vector<Node> _children;
+		std::vector<RootMove> _roots;
+		std::vector<ScenarioAction> _rootInputs;
+
+		Tetromino::Type _queue[TetrominoManager::next_count];
+		unsigned int _queueSize;
+
+		BeamDecision _decision;
+		Statistics _statistics;
+
+	public:
+		BeamSearch(const BotEvaluator& evaluator, unsigned int width, unsigned int previews, unsigned int threads);
+		BeamSearch(const BeamSearch&) = delete;
+		BeamSearch(BeamSearch&&) noexcept = delete;
+		~BeamSearch() = default;
+
+		BeamSearch& operator= (const BeamSearch&) = delete;
+		BeamSearch& operator= (BeamSearch&&) noexcept = delete;
+
+		const BeamDecision& search(const Scenario& scenario);
+
+		const BeamDecision& search(const BotBoard& board, const Tetromino& current, const HoldManager& hold, const std::deque<Tetromino::Type>& queue);
+
+		inline const Statistics& statistics() const { return _statistics; }
+		inline void resetStatistics() { _statistics = {}; }
+
+		inline unsigned int threads() const { return _pool.size(); }
+		inline unsigned int width() const { return _width; }
+		inline unsigned int previews() const { return _previews; }
+
+		/* Repeats the search of a scenario with 1 to maxThreads threads */
+		static std::vector<BeamScaling> measureScaling(const Scenario& scenario, const BotEvaluator& evaluator, unsigned int width, unsigned int previews, unsigned int maxThreads, unsigned int repeats);
+
+	private:
+		void _expandRoot(const BotBoard& board, const Tetromino& current, const HoldManager& hold);
+
+		void _expand(unsigned int index, unsigned int worker);
+
+		void _addChildren(Worker& worker, const Node& parent, UInt32 parentIndex, UInt16 option, const std::vector<Placement>& placements, bool hasHold, Tetromino::Type hold, unsigned int queueIndex);
+
+		void _selectBeam();
+
+		static bool _better(const Node& left, const Node& right);
+	};
+}
@@ -0,0 +1,305 @@
+#include "bot.h"
+#include "beam_search.h"
+#include "trace.h"
+
+#include <bit>
+
+
+namespace core
+{
+	namespace
+	{
+		constexpr double lost_value = -1.0e9;
+	}
+
+	BotEvaluator::BotEvaluator(const BotWeights& weights) :
+		_weights{ weights }
+	{}
+
+	double BotEvaluator::evaluate(const Field& field) const
+	{
+		int heights[Field::columns];
+		int aggregateHeight = 0, maxHeight = 0, bumpiness = 0;
+		for (int column = 0; column < Field::columns; column++)
+		{
+			heights[column] = field.height(column);
+			aggregateHeight += heights[column];
+			maxHeight = std::max(maxHeight, heights[column]);
+			if (column > 0)
+				bumpiness += std::abs(heights[column] - heights[column - 1]);
+		}
+
+		/* Walk down from the top, remembering which columns are covered and by how many cells */
+		int holes = 0, coveredCells = 0;
+		int filledAbove[Field::columns] = {};
+		UInt16 covered = 0;
+		for (int row = maxHeight - 1; row >= 0; row--)
+		{
+			const UInt16 mask = field.rowMask(row);
+			UInt16 rowHoles = static_cast<UInt16>(~mask & covered & Field::full_row_mask);
+			holes += std::popcount(static_cast<unsigned int>(rowHoles));
+
+			for (int column = 0; rowHoles; column++, rowHoles >>= 1)
+				if (rowHoles & 0x1)
+					coveredCells += filledAbove[column];
+
+			for (int column = 0; column < Field::columns; column++)
+				filledAbove[column] += (mask >> column) & 0x1;
+			covered |= mask;
+		}
+
+		int wellDepth = 0;
+		for (int column = 0; column < Field::columns; column++)
+		{
+			const int left = column > 0 ? heights[column - 1] : Field::rows;
+			const int right = column < Field::columns - 1 ? heights[column + 1] : Field::rows;
+			wellDepth = std::max(wellDepth, std::min(left, right) - heights[column]);
+		}
+		wellDepth = std::min(wellDepth, 4);
+
+		return _weights.height * aggregateHeight +
+			_weights.maxHeight * maxHeight +
+			_weights.holes * holes +
+			_weights.coveredCells * coveredCells +
+			_weights.bumpiness * bumpiness +
+			_weights.wellDepth * wellDepth +
+			_weights.tSlots * _countTSlots(field);
+	}
+
+	double BotEvaluator::place(const BotBoard& board, const Placement& placement, BotBoard& result) const
+	{
+		const Tetromino tetromino = placement.tetromino();
+
+		const bool tSpin = placement.type == Tetromino::Type::T && placement.spin && board.field.TSlotCorners(tetromino) > 2;
+		const bool mini = tSpin && placement.kicks > 0 && placement.kicks < 3;
+
+		result.field = board.field;
+		result.field.insert(tetromino);
+
+		int lines = 0, bottom = Field::rows;
+		for (int row = tetromino.row(); row < tetromino.row() + TetrominoShape::box_size; row++)
+			if (row >= 0 && row < Field::rows && result.field.eraseIfComplete(row))
+			{
+				bottom = std::min(bottom, row);
+				lines++;
+			}
+		if (lines > 0)
+			result.field.dropRows(bottom);
+
+		double reward;
+		if (mini)
+			reward = _weights.tSpinMiniClears[std::min(lines, 2)];
+		else if (tSpin)
+			reward = _weights.tSpinClears[std::min(lines, 3)];
+		else reward = _weights.clears[lines];
+
+		result.backToBack = board.backToBack;
+		if (lines > 0)
+		{
+			const bool difficult = lines >= 4 || tSpin;
+			if (board.backToBack)
+				reward += difficult ? _weights.backToBack : -_weights.backToBack;
+			result.backToBack = difficult;
+		}
+
+		return reward;
+	}
+
+	unsigned int BotEvaluator::_countTSlots(const Field& field) const
+	{
+		/* A T pointing down that rests with three of its corners filled */
+		static constexpr RotationState pointing_down = RotationState::Inverse;
+
+		unsigned int slots = 0;
+		for (int column = 0; column <= Field::columns - 3; column++)
+		{
+			const int top = std::max({ field.height(column), field.height(column + 1), field.height(column + 2) });
+			for (int row = 0; row < top && row < Field::rows - 2; row++)
+			{
+				if (!field.fits(Tetromino::Type::T, pointing_down, row, column) || field.fits(Tetromino::Type::T, pointing_down, row - 1, column))
+					continue;
+
+				Tetromino tetromino{ Tetromino::Type::T };
+				tetromino.setRotationState(pointing_down);
+				tetromino.setPosition(row, column);
+				if (field.TSlotCorners(tetromino) > 2)
+				{
+					slots++;
+					break;
+				}
+			}
+		}
+		return slots;
+	}
+
+
+
+	Bot::Bot(const BotWeights& weights, const BotSettings& settings) :
+		_evaluator{ weights },
+		_settings{ settings },
+		_generators{},
+		_beam{},
+		_spawn{ 0 },
+		_inputs{},
+		_nextInput{ 0 },
+		_waitingLanding{ false },
+		_finished{ true },
+		_nodes{ 0 }
+	{
+		_settings.previews = std::min(_settings.previews, max_previews);
+		_settings.threads = std::max(1U, _settings.threads);
+
+		if (_settings.beamWidth > 0)
+			_beam = std::make_unique<BeamSearch>(_evaluator, _settings.beamWidth, _settings.previews, _settings.threads);
+		else _generators.resize(_settings.previews + 1);
+	}
+
+	Bot::Bot(Bot&&) noexcept = default;
+	Bot::~Bot() = default;
+
+	Bot& Bot::operator= (Bot&&) noexcept = default;
+
+	void Bot::update(Scenario& scenario)
+	{
+		if (scenario.state() != Scenario::State::Running || !scenario.hasCurrentTetromino())
+			return;
+
+		if (scenario.spawnCount() != _spawn)
+		{
+			_spawn = scenario.spawnCount();
+			_waitingLanding = false;
+			_finished = false;
+
+			if (_plan(scenario))
+			{
+				/* The held piece spawns a new tetromino, that gets its own plan */
+				_finished = true;
+				scenario.pushAction(ScenarioAction::Hold);
+				return;
+			}
+		}
+
+		if (_finished)
+			return;
+
+		if (_waitingLanding)
+		{
+			if (scenario.tetrominoState() != Scenario::TetrominoState::Frozen)
+				return;
+
+			_waitingLanding = false;
+			scenario.pushAction(ScenarioAction::NormalDrop);
+		}
+
+		for (; _nextInput < _inputs.size(); _nextInput++)
+		{
+			scenario.pushAction(_inputs[_nextInput]);
+			if (_inputs[_nextInput] == ScenarioAction::SoftDrop)
+			{
+				_nextInput++;
+				_waitingLanding = true;
+				return;
+			}
+		}
+
+		scenario.pushAction(ScenarioAction::HardDrop);
+		_finished = true;
+	}
+
+	bool Bot::_plan(const Scenario& scenario)
+	{
+		CORE_TRACE_ZONE("Bot::_plan");
+
+		_inputs.clear();
+		_nextInput = 0;
+
+		if (_beam)
+		{
+			const auto nodes = _beam->statistics().nodes;
+			const BeamDecision& decision = _beam->search(scenario);
+			_nodes += _beam->statistics().nodes - nodes;
+
+			_inputs = decision.inputs;
+			return decision.hold;
+		}
+
+		Tetromino::Type queue[TetrominoManager::next_count];
+		unsigned int queueSize = 0;
+		for (Tetromino::Type type : scenario.nextTetrominoManager().queue())
+			if (queueSize < TetrominoManager::next_count)
+				queue[queueSize++] = type;
+
+		const HoldManager& holdManager = scenario.holdManager();
+		const Tetromino& current = scenario.currentTetromino();
+		const unsigned int depth = _settings.previews + 1;
+
+		BotBoard board;
+		board.field = scenario.field();
+		board.backToBack = scenario.score().hasBackToBack();
+
+		/* Play the current piece where it is now */
+		int best = -1;
+		const auto& placements = _generators[0].generate(board.field, current);
+		const double value = _bestPlacement(board, placements, queue, queueSize, !holdManager.empty(), holdManager.type(), depth, &best);
+
+		if (best >= 0)
+		{
+			const auto inputs = _generators[0].inputs(placements[best]);
+			_inputs.assign(inputs.begin(), inputs.end());
+		}
+
+		if (holdManager.isLock())
+			return false;
+
+		/* Or swap it with the hold slot, taking the next piece when it is empty */
+		double holdValue;
+		if (!holdManager.empty())
+			holdValue = _bestPlacement(board, _generators[0].generate(board.field, holdManager.type()), queue, queueSize, true, current.type(), depth, nullptr);
+		else if (queueSize > 0)
+			holdValue = _bestPlacement(board, _generators[0].generate(board.field, queue[0]), queue + 1, queueSize - 1, true, current.type(), depth, nullptr);
+		else return false;
+
+		return holdValue > value;
+	}
+
+	double Bot::_search(const BotBoard& board, Tetromino::Type piece, bool hasHold, Tetromino::Type hold, const Tetromino::Type* queue, unsigned int queueSize, unsigned int depth)
+	{
+		MoveGenerator& generator = _generators[_settings.previews + 1 - depth];
+
+		double value = _bestPlacement(board, generator.generate(board.field, piece), queue, queueSize, hasHold, hold, depth, nullptr);
+
+		if (hasHold)
+		{
+			if (hold != piece)
+				value = std::max(value, _bestPlacement(board, generator.generate(board.field, hold), queue, queueSize, true, piece, depth, nullptr));
+		}
+		else if (queueSize > 0)
+			value = std::max(value, _bestPlacement(board, generator.generate(board.field, queue[0]), queue + 1, queueSize - 1, true, piece, depth, nullptr));
+
+		return value;
+	}
+
+	double Bot::_bestPlacement(const BotBoard& board, const std::vector<Placement>& placements, const Tetromino::Type* queue, unsigned int queueSize, bool hasHold, Tetromino::Type hold, unsigned int depth, int* best)
+	{
+		double bestValue = lost_value;
+		BotBoard result;
+
+		for (int i = 0; i < static_cast<int>(placements.size()); i++)
+		{
+			double value = _evaluator.place(board, placements[i], result);
+			if (depth > 1 && queueSize > 0)
+				value += _search(result, queue[0], hasHold, hold, queue + 1, queueSize - 1, depth - 1);
+			else value += _evaluator.evaluate(result.field);
+
+			_nodes++;
+			if (value > bestValue)
+			{
+				bestValue = value;
+				if (best)
+					*best = i;
+			}
+		}
+
+		return bestValue;
+	}
+}
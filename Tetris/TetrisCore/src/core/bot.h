@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+
+#include "move_generator.h"
+
+
+namespace core
+{
+	class BeamSearch;
+
+
+
+	/* Weights of the board evaluation. Positive values are rewarded, negative ones are penalized */
+	struct BotWeights
+	{
+		double height = -0.4;
+		double maxHeight = -0.6;
+		double holes = -4.0;
+		double coveredCells = -0.5;
+		double bumpiness = -0.25;
+		double wellDepth = 0.3;
+		double tSlots = 1.5;
+
+		/* Reward of each clear, indexed by lines cleared */
+		double clears[5] = { 0.0, -2.0, -1.5, -1.0, 6.0 };
+		double tSpinClears[4] = { 0.5, 3.0, 8.0, 10.0 };
+		double tSpinMiniClears[3] = { 0.0, 0.5, 1.0 };
+
+		/* Difficult clears while back to back is active are rewarded, breaking it is penalized */
+		double backToBack = 2.0;
+	};
+
+	struct BotSettings
+	{
+		/* Pieces of the next queue looked ahead, besides the current one */
+		unsigned int previews = 1;
+
+		/* 0 searches every placement sequence. Otherwise a beam of that width is kept per level */
+		unsigned int beamWidth = 0;
+
+		/* Threads used by the beam search, counting the caller */
+		unsigned int threads = 1;
+	};
+
+	/* Board seen by the search: the field plus the scoring state that changes the evaluation */
+	struct BotBoard
+	{
+		Field field;
+		bool backToBack = false;
+	};
+
+
+
+	class BotEvaluator
+	{
+	private:
+		BotWeights _weights;
+
+	public:
+		BotEvaluator(const BotWeights& weights = {});
+		BotEvaluator(const BotEvaluator&) = default;
+		BotEvaluator(BotEvaluator&&) noexcept = default;
+		~BotEvaluator() = default;
+
+		BotEvaluator& operator= (const BotEvaluator&) = default;
+		BotEvaluator& operator= (BotEvaluator&&) noexcept = default;
+
+		/* Static value of a board, without the clear rewards */
+		double evaluate(const Field& field) const;
+
+		/* Locks the placement into result and returns the reward of the lines it clears */
+		double place(const BotBoard& board, const Placement& placement, BotBoard& result) const;
+
+		inline const BotWeights& weights() const { return _weights; }
+
+	private:
+		unsigned int _countTSlots(const Field& field) const;
+	};
+
+
+
+	/*
+	 * Automatic player. It plans a placement for every new tetromino looking ahead on the next
+	 * queue and the hold slot, and feeds the inputs to a Scenario through pushAction.
+	 * Plans assume the inputs are faster than gravity, like MoveGenerator does.
+	 */
+	class Bot
+	{
+	public:
+		static constexpr unsigned int max_previews = TetrominoManager::next_count;
+
+	private:
+		BotEvaluator _evaluator;
+		BotSettings _settings;
+
+		std::vector<MoveGenerator> _generators;
+		std::unique_ptr<BeamSearch> _beam;
+
+		UInt64 _spawn;
+		std::vector<ScenarioAction> _inputs;
+		unsigned int _nextInput;
+		bool _waitingLanding;
+		bool _finished;
+
+		UInt64 _nodes;
+
+	public:
+		Bot(const BotWeights& weights = {}, const BotSettings& settings = {});
+		Bot(const Bot&) = delete;
+		Bot(Bot&&) noexcept;
+		~Bot();
+
+		Bot& operator= (const Bot&) = delete;
+		Bot& operator= (Bot&&) noexcept;
+
+		/* Call before every Scenario::update */
+		void update(Scenario& scenario);
+
+		inline const BotEvaluator& evaluator() const { return _evaluator; }
+		inline const BotSettings& settings() const { return _settings; }
+
+		/* Placements evaluated since the bot was created */
+		inline UInt64 nodes() const { return _nodes; }
+
+		inline const BeamSearch* beamSearch() const { return _beam.get(); }
+
+	private:
+		/* Returns true when the best plan starts holding */
+		bool _plan(const Scenario& scenario);
+
+		double _search(const BotBoard& board, Tetromino::Type piece, bool hasHold, Tetromino::Type hold, const Tetromino::Type* queue, unsigned int queueSize, unsigned int depth);
+
+		double _bestPlacement(const BotBoard& board, const std::vector<Placement>& placements, const Tetromino::Type* queue, unsigned int queueSize, bool hasHold, Tetromino::Type hold, unsigned int depth, int* best);
+	};
+}
@@ -0,0 +1,247 @@
+#include "field.h"
+
+#include <bit>
+
+
+namespace core
+{
+	bool Field::collide(const TetrominoShape& shape, int row, int column) const
+	{
+		for (int i = 0; i < TetrominoShape::box_size; i++)
+		{
+			const int shapeRow = row + i;
+			if (!shape.rows[i] || shapeRow < 0 || shapeRow >= Field::rows)
+				continue;
+
+			/* Minos out of the field sides never collide, they are just shifted out of the mask */
+			UInt32 mask = column >= 0 ? static_cast<UInt32>(shape.rows[i]) << column : static_cast<UInt32>(shape.rows[i]) >> -column;
+			if (_rows[shapeRow] & mask)
+				return true;
+		}
+		return false;
+	}
+
+	bool Field::fits(const TetrominoShape& shape, int row, int column) const
+	{
+		if (column <= -TetrominoShape::box_size || column >= Field::columns)
+			return false;
+
+		for (int i = 0; i < TetrominoShape::box_size; i++)
+		{
+			if (!shape.rows[i])
+				continue;
+
+			const int shapeRow = row + i;
+			if (shapeRow < 0 || shapeRow >= Field::rows)
+				return false;
+
+			UInt32 mask;
+			if (column >= 0)
+				mask = static_cast<UInt32>(shape.rows[i]) << column;
+			else
+			{
+				if (shape.rows[i] & ((0x1U << -column) - 1))
+					return false;
+				mask = static_cast<UInt32>(shape.rows[i]) >> -column;
+			}
+
+			if ((mask & ~static_cast<UInt32>(full_row_mask)) || (_rows[shapeRow] & mask))
+				return false;
+		}
+		return true;
+	}
+
+	bool Field::isTopOut(const Tetromino& tetromino) const
+	{
+		auto idxs = tetromino.cellsIndex();
+		for (int idx : idxs)
+			if (idx >= Field::cellCount)
+				return true;
+		return false;
+	}
+
+	bool Field::isBottomOut(const Tetromino& tetromino) const
+	{
+		auto idxs = tetromino.cellsIndex();
+		for (int idx : idxs)
+			if (idx < 0)
+				return true;
+		return false;
+	}
+
+	bool Field::isLeftOut(const Tetromino& tetromino) const
+	{
+		auto cells = tetromino.cellsAsVector();
+		for (const auto& cell : cells)
+			if (cell.x < 0)
+				return true;
+		return false;
+	}
+
+	bool Field::isRightOut(const Tetromino& tetromino) const
+	{
+		auto cells = tetromino.cellsAsVector();
+		for (const auto& cell : cells)
+			if (cell.x >= Field::columns)
+				return true;
+		return false;
+	}
+
+	bool Field::isInside(const TetrominoShape& shape, int row, int column) const
+	{
+		for (const auto& cell : shape.cells)
+			if (!_inside(row + cell.y, column + cell.x))
+				return false;
+		return true;
+	}
+
+	int Field::spawnRow(Tetromino::Type type) const
+	{
+		const auto& shape = Tetromino::shape(type, RotationState::Origin);
+		for (int shift = 0; shift <= max_spawn_shift; shift++)
+			if (!collide(shape, spawn_row + shift, spawn_column))
+				return spawn_row + shift;
+		return -1;
+	}
+
+	int Field::dropDistance(const TetrominoShape& shape, int row, int column) const
+	{
+		int distance = row + TetrominoShape::box_size;
+		for (int i = 0; i < TetrominoShape::box_size; i++)
+		{
+			if (shape.bottoms[i] >= TetrominoShape::box_size)
+				continue;
+
+			const int bottom = row + shape.bottoms[i];
+			const int shapeColumn = column + i;
+			if (shapeColumn < 0 || shapeColumn >= Field::columns || bottom < _heights[shapeColumn])
+			{
+				/* Below the top surface (tucked under an overhang): fall back to probing row by row */
+				distance = 0;
+				while (fits(shape, row - (distance + 1), column))
+					++distance;
+				return distance;
+			}
+
+			distance = std::min(distance, bottom - static_cast<int>(_heights[shapeColumn]));
+		}
+		return distance;
+	}
+
+	int Field::shiftDistance(const TetrominoShape& shape, int row, int column, bool left) const
+	{
+		/* Per shape row, the gap to the nearest filled cell on that side. Tetromino rows have no holes, so the ends are enough */
+		int distance = Field::columns;
+		for (int i = 0; i < TetrominoShape::box_size; i++)
+		{
+			if (!shape.rows[i])
+				continue;
+
+			const UInt32 mask = column >= 0 ? static_cast<UInt32>(shape.rows[i]) << column : static_cast<UInt32>(shape.rows[i]) >> -column;
+			const UInt32 filled = _rows[row + i];
+
+			if (left)
+			{
+				const int first = std::countr_zero(mask);
+				const UInt32 obstacles = filled & ((0x1U << first) - 1);
+				distance = std::min(distance, first - static_cast<int>(std::bit_width(obstacles)));
+			}
+			else
+			{
+				const int last = static_cast<int>(std::bit_width(mask)) - 1;
+				const UInt32 obstacles = (filled | ~static_cast<UInt32>(full_row_mask)) & ~((0x2U << last) - 1);
+				distance = std::min(distance, std::countr_zero(obstacles) - last - 1);
+			}
+		}
+		return distance;
+	}
+
+	void Field::insert(const Tetromino& tetromino)
+	{
+		auto cells = tetromino.cellsAsVector();
+		auto color = tetromino.color();
+
+		for (const auto& cell : cells)
+		{
+			if (_inside(cell.y, cell.x))
+			{
+				_rows[cell.y] |= static_cast<UInt16>(0x1 << cell.x);
+				_colors[cell.y * Field::columns + cell.x] = color;
+				if (cell.y >= _heights[cell.x])
+					_heights[cell.x] = static_cast<UInt8>(cell.y + 1);
+			}
+		}
+
+		_revision++;
+	}
+
+	bool Field::eraseIfComplete(int row)
+	{
+		row = utils::clamp(row, 0, Field::rows - 1);
+		if (_rows[row] != Field::full_row_mask)
+			return false;
+
+		_rows[row] = 0;
+		std::memset(_colors + (row * Field::columns), 0, sizeof(CellColor) * Field::columns);
+
+		_updateHeights();
+		_revision++;
+		return true;
+	}
+
+	void Field::dropRows(int bottomRow)
+	{
+		bottomRow = utils::clamp(bottomRow, 0, Field::rows - 1);
+
+		/* Check if bottomRow is empty. If not, return */
+		if (_rows[bottomRow])
+			return;
+
+		/* Compact every non empty row over bottomRow */
+		for (int row = bottomRow + 1; row < Field::rows; row++)
+		{
+			if (!_rows[row])
+				continue;
+
+			_rows[bottomRow] = _rows[row];
+			std::memcpy(_colors + (bottomRow * Field::columns), _colors + (row * Field::columns), sizeof(CellColor) * Field::columns);
+			bottomRow++;
+		}
+
+		for (int row = bottomRow; row < Field::rows; row++)
+			_rows[row] = 0;
+		std::memset(_colors + (bottomRow * Field::columns), 0, sizeof(CellColor) * (Field::rows - bottomRow) * Field::columns);
+
+		_updateHeights();
+		_revision++;
+	}
+
+	unsigned int Field::TSlotCorners(const Tetromino& tetromino) const
+	{
+		if (tetromino.type() != Tetromino::Type::T)
+			return 0;
+
+		int row = tetromino.row();
+		int column = tetromino.column();
+
+		return static_cast<unsigned int>(occupied(row, column)) +
+			static_cast<unsigned int>(occupied(row, column + 2)) +
+			static_cast<unsigned int>(occupied(row + 2, column)) +
+			static_cast<unsigned int>(occupied(row + 2, column + 2));
+	}
+
+	void Field::_updateHeights()
+	{
+		UInt16 pending = Field::full_row_mask;
+		std::memset(_heights, 0, sizeof(_heights));
+
+		for (int row = Field::rows - 1; row >= 0 && pending; row--)
+		{
+			UInt16 found = _rows[row] & pending;
+			pending &= ~found;
+			for (int column = 0; found; column++, found >>= 1)
+				if (found & 0x1)
+					_heights[column] = static_cast<UInt8>(row + 1);
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "tetromino.h"
+
+
+namespace core
+{
+	class Field
+	{
+	public:
+		static constexpr int rows = 22;
+		static constexpr int columns = 10;
+		static constexpr int visible_rows = rows - 2;
+
+		static constexpr UInt16 full_row_mask = static_cast<UInt16>((1 << columns) - 1);
+
+		static constexpr int spawn_row = rows - 5;
+		static constexpr int spawn_column = (columns / 2) - (Tetromino::columns / 2);
+		static constexpr int max_spawn_shift = 2;
+
+	private:
+		static constexpr int cellCount = rows * columns;
+
+	private:
+		/* Occupancy model: one bit per column in each row mask, plus the color of each cell */
+		UInt16 _rows[rows] = {};
+		CellColor _colors[cellCount] = {};
+
+		/* Top surface cache: rows up to the highest occupied cell of each column */
+		UInt8 _heights[columns] = {};
+
+		/* Increased on every change, so views can detect when they must be refreshed */
+		UInt64 _revision = 0;
+
+	public:
+		Field() = default;
+		Field(const Field&) = default;
+		Field(Field&&) noexcept = default;
+		~Field() = default;
+
+		Field& operator= (const Field&) = default;
+		Field& operator= (Field&&) noexcept = default;
+
+		/* Shape based probes, so candidate positions can be tested without building a Tetromino */
+		bool collide(const TetrominoShape& shape, int row, int column) const;
+		bool isInside(const TetrominoShape& shape, int row, int column) const;
+
+		/* True when the shape is fully inside the field and overlaps no occupied cell */
+		bool fits(const TetrominoShape& shape, int row, int column) const;
+
+		inline bool fits(Tetromino::Type type, RotationState rotation, int row, int column) const
+		{
+			return fits(Tetromino::shape(type, rotation), row, column);
+		}
+
+		bool isTopOut(const Tetromino& tetromino) const;
+		bool isBottomOut(const Tetromino& tetromino) const;
+		bool isLeftOut(const Tetromino& tetromino) const;
+		bool isRightOut(const Tetromino& tetromino) const;
+
+		inline bool collide(const Tetromino& tetromino) const { return collide(tetromino.shape(), tetromino.row(), tetromino.column()); }
+		inline bool isInside(const Tetromino& tetromino) const { return isInside(tetromino.shape(), tetromino.row(), tetromino.column()); }
+		inline bool fits(const Tetromino& tetromino) const { return fits(tetromino.shape(), tetromino.row(), tetromino.column()); }
+
+		/* Row where a new tetromino spawns, shifted up when the origin is blocked. -1 means block out */
+		int spawnRow(Tetromino::Type type) const;
+
+		/* Rows a fitting shape can fall before landing */
+		int dropDistance(const TetrominoShape& shape, int row, int column) const;
+
+		inline int dropDistance(const Tetromino& tetromino) const { return dropDistance(tetromino.shape(), tetromino.row(), tetromino.column()); }
+
+		/* Columns a fitting shape can slide to one side before touching a wall or a filled cell */
+		int shiftDistance(const TetrominoShape& shape, int row, int column, bool left) const;
+
+		inline int shiftDistance(const Tetromino& tetromino, bool left) const { return shiftDistance(tetromino.shape(), tetromino.row(), tetromino.column(), left); }
+
+		void insert(const Tetromino& tetromino);
+
+		bool eraseIfComplete(int row);
+
+		void dropRows(int bottomRow);
+
+		unsigned int TSlotCorners(const Tetromino& tetromino) const;
+
+		inline UInt64 revision() const { return _revision; }
+
+		inline UInt16 rowMask(int row) const { return _rows[utils::clamp(row, 0, rows - 1)]; }
+
+		inline int height(int column) const { return _heights[utils::clamp(column, 0, columns - 1)]; }
+
+		inline bool occupied(int row, int column) const
+		{
+			return _inside(row, column) && _occupied(row, column);
+		}
+
+		inline CellColor color(int row, int column) const
+		{
+			return _colors[utils::clamp(row, 0, rows - 1) * columns + utils::clamp(column, 0, columns - 1)];
+		}
+
+		inline CellColor operator[] (const std::pair<int, int> location) const { return color(location.first, location.second); }
+
+	private:
+		static constexpr bool _inside(int row, int column) { return row >= 0 && row < rows && column >= 0 && column < columns; }
+
+		inline bool _occupied(int row, int column) const { return (_rows[row] >> column) & 0x1; }
+
+		void _updateHeights();
+	};
+}
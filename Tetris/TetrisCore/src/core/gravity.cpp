@@ -0,0 +1,110 @@
+#include "gravity.h"
+
+#include <limits>
+
+
+namespace core
+{
+	void GravityClock::setGravityLevel(unsigned int level)
+	{
+		level = std::max(1U, level);
+
+		/* Tetris Worlds gravity formula */
+		double time = std::pow(0.8 - (static_cast<double>(level - 1) * 0.0007), static_cast<double>(level - 1));
+		Int64 microTime = static_cast<Int64>(time * 1000000);
+
+		_waiting = Time{ std::max(microTime, min_waiting_time) };
+		reset();
+	}
+
+	void GravityClock::updateWaiting(const Time& delta)
+	{
+		_remaining -= delta;
+	}
+
+	void GravityClock::updateFreezing(const Time& delta)
+	{
+		if (_freezing > Time::zero())
+			_freezing -= delta;
+		else _freezing = Time::zero();
+	}
+
+	void GravityClock::updateInserting(const Time& delta)
+	{
+		if (_inserting > Time::zero())
+			_inserting -= delta;
+		else _inserting = Time::zero();
+	}
+
+	Int64 GravityClock::pendingDrops() const
+	{
+		if (_mode == Mode::Hard)
+			return std::numeric_limits<Int64>::max();
+		if (_remaining > Time::zero())
+			return 0;
+
+		const Int64 step = _mode == Mode::Soft ? GravityClock::soft_drop_time : _waiting.count();
+		return (-_remaining.count() / step) + 1;
+	}
+
+	void GravityClock::registerDrop(Int64 count)
+	{
+		switch (_mode)
+		{
+			default:
+			case Mode::Normal:
+				_remaining += _waiting * count;
+				if (_remaining > _waiting)
+					_remaining = _waiting;
+				break;
+
+			case Mode::Soft:
+				_remaining += Time{ GravityClock::soft_drop_time } * count;
+				if (_remaining > _waiting)
+					_remaining = _waiting;
+				break;
+
+			case Mode::Hard:
+				_remaining = Time::zero();
+		}
+	}
+
+	void GravityClock::resetWaiting()
+	{
+		switch (_mode)
+		{
+			default:
+			case Mode::Normal:
+				_remaining = _waiting;
+				break;
+
+			case Mode::Soft:
+				_remaining = _waiting.count() < GravityClock::soft_drop_time
+					? _waiting
+					: Time{ GravityClock::soft_drop_time };
+				break;
+
+			case Mode::Hard:
+				_remaining = Time::zero();
+				break;
+		}
+	}
+
+	void GravityClock::setMode(Mode mode)
+	{
+		if (mode == _mode)
+			return;
+
+		_mode = mode;
+		if (_remaining > Time::zero())
+		{
+			if (mode == Mode::Soft)
+			{
+				if (_remaining.count() > GravityClock::soft_drop_time)
+					_remaining = Time{ GravityClock::soft_drop_time };
+			}
+			else if (mode == Mode::Hard)
+				_remaining = Time::zero();
+		}
+	}
+}
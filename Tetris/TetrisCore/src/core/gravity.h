@@ -0,0 +1,69 @@
+#pragma once
+
+#include "basics.h"
+
+
+namespace core
+{
+	class GravityClock
+	{
+	private:
+		static constexpr Int64 min_waiting_time = static_cast<Int64>(0.05 / 60.0 * 1000000.0); // 20G //
+		static constexpr Int64 soft_drop_time = static_cast<Int64>(1.0 / 60.0 * 1000000.0); // 1G //
+		static constexpr Int64 freeze_time = static_cast<Int64>(0.5 * 1000000.0); // 0.5 seconds //
+		static constexpr Int64 insertion_time = static_cast<Int64>(0.5 * 1000000.0); // 0.5 seconds //
+		static constexpr Int64 insertion_with_erase_time = static_cast<Int64>(0.75 * 1000000.0); // 0.75 seconds //
+
+
+	public:
+		enum class Mode { Normal, Soft, Hard };
+
+	private:
+		Time _waiting = Time::zero();
+		Time _remaining = Time::zero();
+		Time _freezing = Time::zero();
+		Time _inserting = Time::zero();
+		Mode _mode = Mode::Normal;
+
+	public:
+		GravityClock() = default;
+		GravityClock(const GravityClock&) = default;
+		GravityClock(GravityClock&&) noexcept = default;
+		~GravityClock() = default;
+
+		GravityClock& operator= (const GravityClock&) = default;
+		GravityClock& operator= (GravityClock&&) noexcept = default;
+
+		void setGravityLevel(unsigned int level);
+
+		void updateWaiting(const Time& delta);
+		void updateFreezing(const Time& delta);
+		void updateInserting(const Time& delta);
+
+		/* Rows elapsed since the last drop, given the waiting time of the current mode */
+		Int64 pendingDrops() const;
+
+		void registerDrop(Int64 count = 1);
+
+		void resetWaiting();
+
+		void setMode(Mode mode);
+
+		inline void resetMode() { _mode = Mode::Normal; }
+		inline Mode mode() const { return _mode; }
+
+		inline void freeze() { _freezing = Time{ freeze_time }; }
+		inline void insertion() { _inserting = Time{ insertion_time }; }
+		inline void erasingInsertion() { _inserting = Time{ insertion_with_erase_time }; }
+		inline void resetFreezing() { _freezing = Time::zero(); }
+		inline void resetInserting() { _inserting = Time::zero(); }
+		inline void reset() { resetMode(), resetWaiting(), resetFreezing(); }
+
+		inline bool isFrozen() const { return _freezing > Time::zero(); }
+		inline bool isWaiting() const
+		{
+			return _mode != Mode::Hard && _remaining > Time::zero();
+		}
+		inline bool isInserting() const { return _inserting > Time::zero(); }
+	};
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "basics.h"
+
+
+namespace core::geometry
+{
+	/* Kick tables are shared by piece class: J, L, S, T and Z use the same one */
+	enum class KickClass { Common, I, O };
+
+	constexpr int kick_class_count = static_cast<int>(KickClass::O) + 1;
+	constexpr int kick_rotation_count = 4;
+	constexpr int max_kick_tries = 6;
+
+	/* Type ids follow Tetromino::Type (I, O, T, J, L, S, Z) */
+	constexpr KickClass kick_class(int type) { return type == 0 ? KickClass::I : type == 1 ? KickClass::O : KickClass::Common; }
+
+
+	/*
+	 * SRS offsets of each rotation state, as { x, y } with y going up. The kick of a
+	 * rotation is the offset of the source state minus the offset of the target state.
+	 */
+	constexpr Point srs_offsets[kick_class_count][kick_rotation_count][5] = {
+		{ // Common //
+			{ { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } },
+			{ { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } },
+			{ { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } },
+			{ { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } }
+		},
+		{ // I //
+			{ { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, 0 }, { 2, 0 } },
+			{ { 0, 0 }, { 1, 0 }, { 1, 0 }, { 1, 1 }, { 1, -2 } },
+			{ { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, -1 }, { -1, -1 } },
+			{ { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, -2 }, { 0, 1 } }
+		},
+		{ // O //
+			{ { 0, 0 } },
+			{ { 0, 0 } },
+			{ { 0, 0 } },
+			{ { 0, 0 } }
+		}
+	};
+
+	/* 180 degree rotations are not part of SRS. They use the common SRS+ kicks for every piece but O */
+	constexpr Point half_turn_kicks[kick_rotation_count][max_kick_tries] = {
+		{ { 0, 0 }, { 0, 1 }, { 1, 1 }, { -1, 1 }, { 1, 0 }, { -1, 0 } },  // 0 -> 2 //
+		{ { 0, 0 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 0, 2 }, { 0, 1 } },    // R -> L //
+		{ { 0, 0 }, { 0, -1 }, { -1, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 } }, // 2 -> 0 //
+		{ { 0, 0 }, { -1, 0 }, { -1, 2 }, { -1, 1 }, { 0, 2 }, { 0, 1 } }  // L -> R //
+	};
+
+
+	struct KickData
+	{
+		int count = 0;
+		Point tries[max_kick_tries] = {};
+	};
+
+	typedef std::array<std::array<std::array<KickData, kick_rotation_count>, kick_rotation_count>, kick_class_count> KickTable;
+
+	constexpr KickData make_kick(KickClass kclass, int from, int to)
+	{
+		KickData data;
+		const int cls = static_cast<int>(kclass);
+
+		if (from == to || kclass == KickClass::O)
+			data.count = 1;
+		else if ((from + 2) % kick_rotation_count == to)
+		{
+			data.count = max_kick_tries;
+			for (int i = 0; i < data.count; i++)
+				data.tries[i] = half_turn_kicks[from][i];
+		}
+		else
+		{
+			data.count = 5;
+			for (int i = 0; i < data.count; i++)
+				data.tries[i] = srs_offsets[cls][from][i] - srs_offsets[cls][to][i];
+		}
+
+		return data;
+	}
+
+	constexpr KickTable make_kicks()
+	{
+		KickTable table;
+		for (int cls = 0; cls < kick_class_count; cls++)
+			for (int from = 0; from < kick_rotation_count; from++)
+				for (int to = 0; to < kick_rotation_count; to++)
+					table[cls][from][to] = make_kick(static_cast<KickClass>(cls), from, to);
+		return table;
+	}
+
+	constexpr KickTable kicks = make_kicks();
+
+
+
+	/* SRS reference kick tests, as published. Used to validate the table built from the offsets */
+	struct KickReference
+	{
+		int from;
+		int to;
+		Point tries[5];
+	};
+
+	constexpr KickReference srs_common_reference[] = {
+		{ 0, 1, { { 0, 0 }, { -1, 0 }, { -1, 1 }, { 0, -2 }, { -1, -2 } } },
+		{ 1, 0, { { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } } },
+		{ 1, 2, { { 0, 0 }, { 1, 0 }, { 1, -1 }, { 0, 2 }, { 1, 2 } } },
+		{ 2, 1, { { 0, 0 }, { -1, 0 }, { -1, 1 }, { 0, -2 }, { -1, -2 } } },
+		{ 2, 3, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, -2 }, { 1, -2 } } },
+		{ 3, 2, { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } } },
+		{ 3, 0, { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0, 2 }, { -1, 2 } } },
+		{ 0, 3, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, -2 }, { 1, -2 } } }
+	};
+
+	constexpr KickReference srs_i_reference[] = {
+		{ 0, 1, { { 0, 0 }, { -2, 0 }, { 1, 0 }, { -2, -1 }, { 1, 2 } } },
+		{ 1, 0, { { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, 1 }, { -1, -2 } } },
+		{ 1, 2, { { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, 2 }, { 2, -1 } } },
+		{ 2, 1, { { 0, 0 }, { 1, 0 }, { -2, 0 }, { 1, -2 }, { -2, 1 } } },
+		{ 2, 3, { { 0, 0 }, { 2, 0 }, { -1, 0 }, { 2, 1 }, { -1, -2 } } },
+		{ 3, 2, { { 0, 0 }, { -2, 0 }, { 1, 0 }, { -2, -1 }, { 1, 2 } } },
+		{ 3, 0, { { 0, 0 }, { 1, 0 }, { -2, 0 }, { 1, -2 }, { -2, 1 } } },
+		{ 0, 3, { { 0, 0 }, { -1, 0 }, { 2, 0 }, { -1, 2 }, { 2, -1 } } }
+	};
+
+	template<Size _Count>
+	constexpr bool matches_reference(KickClass kclass, const KickReference (&reference)[_Count])
+	{
+		for (const auto& ref : reference)
+		{
+			const KickData& data = kicks[static_cast<int>(kclass)][ref.from][ref.to];
+			if (data.count != 5)
+				return false;
+			for (int i = 0; i < data.count; i++)
+				if (!(data.tries[i] == ref.tries[i]))
+					return false;
+		}
+		return true;
+	}
+
+	constexpr bool o_never_kicks()
+	{
+		for (int from = 0; from < kick_rotation_count; from++)
+			for (int to = 0; to < kick_rotation_count; to++)
+			{
+				const KickData& data = kicks[static_cast<int>(KickClass::O)][from][to];
+				if (data.count != 1 || !(data.tries[0] == Point{}))
+					return false;
+			}
+		return true;
+	}
+
+	static_assert(matches_reference(KickClass::Common, srs_common_reference), "J, L, S, T, Z kicks must match SRS");
+	static_assert(matches_reference(KickClass::I, srs_i_reference), "I kicks must match SRS");
+	static_assert(o_never_kicks(), "O never kicks");
+	static_assert(kicks[0][0][2].count == max_kick_tries && kicks[1][1][3].tries[1] == Point{ 1, 0 }, "180 kicks");
+}
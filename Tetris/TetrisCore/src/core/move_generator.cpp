@@ -0,0 +1,150 @@
+#include "move_generator.h"
+
+
+namespace core
+{
+	MoveGenerator::MoveGenerator() :
+		_nodes{},
+		_placements{},
+		_inputs{},
+		_keys{}
+	{
+		_nodes.reserve(state_count);
+		_placements.reserve(256);
+		_inputs.reserve(1024);
+		_keys.reserve(256);
+	}
+
+	const std::vector<Placement>& MoveGenerator::generate(const Field& field, Tetromino::Type type)
+	{
+		const int row = field.spawnRow(type);
+		if (row < 0)
+		{
+			_placements.clear();
+			_inputs.clear();
+			return _placements;
+		}
+
+		Tetromino tetromino{ type };
+		tetromino.setPosition(row, Field::spawn_column);
+		return generate(field, tetromino);
+	}
+
+	const std::vector<Placement>& MoveGenerator::generate(const Field& field, const Tetromino& tetromino)
+	{
+		static constexpr ScenarioAction rotations[] = { ScenarioAction::RotateRight, ScenarioAction::RotateLeft, ScenarioAction::Rotate180 };
+		static constexpr int turns[] = { 1, -1, 2 };
+
+		const Tetromino::Type type = tetromino.type();
+
+		_nodes.clear();
+		_placements.clear();
+		_inputs.clear();
+		_keys.clear();
+		std::memset(_visited, 0, sizeof(_visited));
+
+		if (!field.fits(tetromino))
+			return _placements;
+
+		_push(field, type, tetromino.row(), tetromino.column(), tetromino.rotationState(), false, 0, ScenarioAction::None, -1);
+
+		for (int index = 0; index < static_cast<int>(_nodes.size()); index++)
+		{
+			const Node node = _nodes[index];
+			const RotationState rotation = node.rotation;
+			const auto& shape = Tetromino::shape(type, rotation);
+
+			_push(field, type, node.row, node.column - 1, rotation, false, 0, ScenarioAction::MoveLeft, index);
+			_push(field, type, node.row, node.column + 1, rotation, false, 0, ScenarioAction::MoveRight, index);
+
+			for (int i = 0; i < 3; i++)
+			{
+				const RotationState to = rotation + turns[i];
+				const auto& toShape = Tetromino::shape(type, to);
+				const auto& kicks = Tetromino::kicks(type, rotation, to);
+
+				for (int kickId = 0; kickId < kicks.count; kickId++)
+				{
+					const int row = node.row + kicks.tries[kickId].y;
+					const int column = node.column + kicks.tries[kickId].x;
+					if (field.fits(toShape, row, column))
+					{
+						_push(field, type, row, column, to, true, static_cast<unsigned int>(kickId), rotations[i], index);
+						break;
+					}
+				}
+			}
+
+			const int distance = field.dropDistance(shape, node.row, node.column);
+			if (distance > 0)
+				_push(field, type, node.row - distance, node.column, rotation, false, 0, ScenarioAction::SoftDrop, index);
+			else _addPlacement(type, node, index);
+		}
+
+		return _placements;
+	}
+
+	void MoveGenerator::_push(const Field& field, Tetromino::Type type, int row, int column, RotationState rotation, bool spin, unsigned int kicks, ScenarioAction input, int parent)
+	{
+		/* Only T gets scored for spins, the rest of pieces do not need separate states */
+		spin = spin && type == Tetromino::Type::T;
+		kicks = spin ? kicks : 0;
+
+		if (row < min_row || row >= Field::rows || column < min_column || column >= Field::columns)
+			return;
+
+		bool& visited = _visited[_stateIndex(row, column, rotation.state, spin)];
+		if (visited)
+			return;
+
+		if (input == ScenarioAction::MoveLeft || input == ScenarioAction::MoveRight)
+		{
+			if (!field.fits(type, rotation, row, column))
+				return;
+		}
+
+		visited = true;
+		_nodes.push_back({
+			static_cast<Int8>(row),
+			static_cast<Int8>(column),
+			static_cast<Int8>(rotation.state),
+			spin,
+			static_cast<UInt8>(kicks),
+			input,
+			static_cast<Int16>(parent)
+		});
+	}
+
+	void MoveGenerator::_addPlacement(Tetromino::Type type, const Node& node, int index)
+	{
+		/* Rotations of I, S, Z and O may cover the same cells, keep only the first (shortest) way to reach them */
+		const auto& shape = Tetromino::shape(type, node.rotation);
+		UInt64 key = static_cast<UInt64>(node.spin);
+		for (const auto& cell : shape.cells)
+			key = (key << 8) | static_cast<UInt64>((node.row + cell.y) * Field::columns + node.column + cell.x);
+
+		for (UInt64 other : _keys)
+			if (other == key)
+				return;
+		_keys.push_back(key);
+
+		Placement placement;
+		placement.type = type;
+		placement.rotation = node.rotation;
+		placement.row = node.row;
+		placement.column = node.column;
+		placement.spin = node.spin;
+		placement.kicks = node.kicks;
+		placement.firstInput = static_cast<unsigned int>(_inputs.size());
+
+		/* Walk back to the root. A trailing soft drop is left to the final hard drop */
+		for (int i = index; _nodes[i].parent >= 0; i = _nodes[i].parent)
+			if (!(i == index && _nodes[i].input == ScenarioAction::SoftDrop))
+				_inputs.push_back(_nodes[i].input);
+
+		placement.inputCount = static_cast<unsigned int>(_inputs.size()) - placement.firstInput;
+		std::reverse(_inputs.begin() + placement.firstInput, _inputs.end());
+
+		_placements.push_back(placement);
+	}
+}
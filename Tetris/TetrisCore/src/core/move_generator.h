@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include "scenario.h"
+
+
+namespace core
+{
+	/*
+	 * A lockable resting place of a tetromino. The inputs that reach it are kept by the
+	 * MoveGenerator that found it. A final hard drop is implied after the last input.
+	 */
+	struct Placement
+	{
+		Tetromino::Type type = Tetromino::Type::I;
+		RotationState rotation;
+		int row = 0;
+		int column = 0;
+
+		/* Last input was a rotation, with the kick test that succeeded. Needed for T-spin scoring */
+		bool spin = false;
+		unsigned int kicks = 0;
+
+		unsigned int firstInput = 0;
+		unsigned int inputCount = 0;
+
+		inline Tetromino tetromino() const
+		{
+			Tetromino piece{ type };
+			piece.setRotationState(rotation);
+			piece.setPosition(row, column);
+			return piece;
+		}
+	};
+
+
+
+	/*
+	 * Breadth first search over position and rotation states of one piece, using the same
+	 * fits/kick rules as Scenario. Inputs are ScenarioActions, where SoftDrop stands for
+	 * holding soft drop until the piece lands. Gravity during the inputs is not modeled.
+	 */
+	class MoveGenerator
+	{
+	private:
+		static constexpr int min_row = -TetrominoShape::box_size;
+		static constexpr int min_column = -(TetrominoShape::box_size - 1);
+		static constexpr int row_span = Field::rows - min_row;
+		static constexpr int column_span = Field::columns - min_column;
+
+		/* T states are split by whether they were reached by a rotation, other pieces only use the first half */
+		static constexpr int state_count = 2 * geometry::rotation_count * row_span * column_span;
+
+		struct Node
+		{
+			Int8 row;
+			Int8 column;
+			Int8 rotation;
+			bool spin;
+			UInt8 kicks;
+			ScenarioAction input;
+			Int16 parent;
+		};
+
+	private:
+		std::vector<Node> _nodes;
+		std::vector<Placement> _placements;
+		std::vector<ScenarioAction> _inputs;
+		std::vector<UInt64> _keys;
+		bool _visited[state_count] = {};
+
+	public:
+		MoveGenerator();
+		MoveGenerator(const MoveGenerator&) = default;
+		MoveGenerator(MoveGenerator&&) noexcept = default;
+		~MoveGenerator() = default;
+
+		MoveGenerator& operator= (const MoveGenerator&) = default;
+		MoveGenerator& operator= (MoveGenerator&&) noexcept = default;
+
+		/* Placements of a piece starting at its spawn position. None if it would block out */
+		const std::vector<Placement>& generate(const Field& field, Tetromino::Type type);
+
+		/* Placements of a piece starting where the given tetromino is */
+		const std::vector<Placement>& generate(const Field& field, const Tetromino& tetromino);
+
+		inline const std::vector<Placement>& placements() const { return _placements; }
+
+		inline std::span<const ScenarioAction> inputs(const Placement& placement) const
+		{
+			return { _inputs.data() + placement.firstInput, placement.inputCount };
+		}
+
+	private:
+		void _push(const Field& field, Tetromino::Type type, int row, int column, RotationState rotation, bool spin, unsigned int kicks, ScenarioAction input, int parent);
+
+		void _addPlacement(Tetromino::Type type, const Node& node, int index);
+
+		static constexpr int _stateIndex(int row, int column, int rotation, bool spin)
+		{
+			return (((static_cast<int>(spin) * geometry::rotation_count + rotation) * row_span) + (row - min_row)) * column_span + (column - min_column);
+		}
+	};
+}
@@ -0,0 +1,14 @@
+#include "random.h"
+
+#include <random>
+
+
+namespace core
+{
+	UInt64 Random::randomSeed()
+	{
+		std::random_device device;
+		const UInt64 entropy = (static_cast<UInt64>(device()) << 32) ^ static_cast<UInt64>(device());
+		return entropy ^ static_cast<UInt64>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <limits>
+
+#include "basics.h"
+
+
+namespace core
+{
+	/*
+	 * xoshiro256** generator, seeded through splitmix64. Every operation is defined here, so the
+	 * same seed gives the same numbers on every compiler and standard library.
+	 */
+	class Random
+	{
+	public:
+		typedef UInt64 result_type;
+
+	private:
+		UInt64 _state[4] = {};
+		UInt64 _seed = 0;
+
+	public:
+		constexpr Random(UInt64 seed = 0) { reseed(seed); }
+		constexpr Random(const Random&) = default;
+		constexpr Random(Random&&) noexcept = default;
+		~Random() = default;
+
+		constexpr Random& operator= (const Random&) = default;
+		constexpr Random& operator= (Random&&) noexcept = default;
+
+		constexpr void reseed(UInt64 seed)
+		{
+			_seed = seed;
+			for (auto& word : _state)
+			{
+				/* splitmix64 */
+				seed += 0x9E3779B97F4A7C15ULL;
+				UInt64 z = seed;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				word = z ^ (z >> 31);
+			}
+		}
+
+		constexpr UInt64 next()
+		{
+			const UInt64 result = _rotl(_state[1] * 5, 7) * 9;
+			const UInt64 t = _state[1] << 17;
+
+			_state[2] ^= _state[0];
+			_state[3] ^= _state[1];
+			_state[1] ^= _state[2];
+			_state[0] ^= _state[3];
+			_state[2] ^= t;
+			_state[3] = _rotl(_state[3], 45);
+
+			return result;
+		}
+
+		/* Uniform value in [0, bound), without modulo bias */
+		constexpr UInt32 below(UInt32 bound)
+		{
+			UInt64 product = (next() >> 32) * bound;
+			UInt32 low = static_cast<UInt32>(product);
+			if (low < bound)
+			{
+				const UInt32 threshold = static_cast<UInt32>(-static_cast<Int32>(bound)) % bound;
+				while (low < threshold)
+				{
+					product = (next() >> 32) * bound;
+					low = static_cast<UInt32>(product);
+				}
+			}
+			return static_cast<UInt32>(product >> 32);
+		}
+
+		/* Fisher-Yates shuffle, so the order does not depend on the std::shuffle implementation */
+		template<typename _Ty>
+		constexpr void shuffle(_Ty* values, Size count)
+		{
+			for (Size i = count; i > 1; i--)
+			{
+				const Size j = below(static_cast<UInt32>(i));
+				_Ty tmp = values[i - 1];
+				values[i - 1] = values[j];
+				values[j] = tmp;
+			}
+		}
+
+		constexpr UInt64 seed() const { return _seed; }
+
+		constexpr UInt64 operator() () { return next(); }
+
+		static constexpr UInt64 min() { return 0; }
+		static constexpr UInt64 max() { return std::numeric_limits<UInt64>::max(); }
+
+		/* Seed for games that do not ask for one */
+		static UInt64 randomSeed();
+
+	private:
+		static constexpr UInt64 _rotl(UInt64 value, int shift) { return (value << shift) | (value >> (64 - shift)); }
+	};
+}
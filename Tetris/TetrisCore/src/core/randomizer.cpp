@@ -0,0 +1,24 @@
+#include "randomizer.h"
+
+
+namespace core
+{
+	AnyRandomizer::AnyRandomizer(RandomizerType type, UInt64 seed) :
+		_randomizer{}
+	{
+		switch (type)
+		{
+			default:
+			case RandomizerType::SevenBag: _randomizer.emplace<Randomizer<randomizer::SevenBag>>(seed); break;
+			case RandomizerType::FourteenBag: _randomizer.emplace<Randomizer<randomizer::FourteenBag>>(seed); break;
+			case RandomizerType::SevenPlusOne: _randomizer.emplace<Randomizer<randomizer::SevenPlusOne>>(seed); break;
+			case RandomizerType::History: _randomizer.emplace<Randomizer<randomizer::History>>(seed); break;
+			case RandomizerType::Random: _randomizer.emplace<Randomizer<randomizer::Uniform>>(seed); break;
+		}
+	}
+
+	void AnyRandomizer::generate(Tetromino::Type* types, Size count)
+	{
+		std::visit([types, count](auto& randomizer) { randomizer.generate(types, count); }, _randomizer);
+	}
+}
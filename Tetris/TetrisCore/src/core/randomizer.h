@@ -0,0 +1,198 @@
+#pragma once
+
+#include <variant>
+#include <string_view>
+
+#include "tetromino.h"
+#include "random.h"
+
+
+namespace core
+{
+	enum class RandomizerType
+	{
+		SevenBag,
+		FourteenBag,
+		SevenPlusOne,
+		History,
+		Random
+	};
+}
+
+namespace utils
+{
+	constexpr const char* randomizer_names[] = { "7-bag", "14-bag", "7+1", "history-4", "random" };
+
+	constexpr const char* randomizer_name(core::RandomizerType type) { return randomizer_names[static_cast<int>(type)]; }
+
+	constexpr bool randomizer_from_name(std::string_view name, core::RandomizerType& type)
+	{
+		for (int i = 0; i < static_cast<int>(sizeof(randomizer_names) / sizeof(randomizer_names[0])); i++)
+			if (name == randomizer_names[i])
+				return type = static_cast<core::RandomizerType>(i), true;
+		return false;
+	}
+}
+
+namespace core
+{
+
+	/* Randomizer policies. Each one draws the next piece from the generator it is given */
+	namespace randomizer
+	{
+		/* Shuffled bag with every piece _Copies times plus _Extra pieces drawn at random */
+		template<int _Copies, int _Extra>
+		class Bag
+		{
+		public:
+			static constexpr int size = (Tetromino::type_count * _Copies) + _Extra;
+
+		private:
+			Tetromino::Type _bag[size] = {};
+			int _remaining = 0;
+
+		public:
+			inline Tetromino::Type take(Random& random)
+			{
+				if (_remaining < 1)
+					_generate(random);
+				return _bag[--_remaining];
+			}
+
+		private:
+			void _generate(Random& random)
+			{
+				for (int i = 0; i < Tetromino::type_count * _Copies; i++)
+					_bag[i] = static_cast<Tetromino::Type>(i % Tetromino::type_count);
+				for (int i = Tetromino::type_count * _Copies; i < size; i++)
+					_bag[i] = static_cast<Tetromino::Type>(random.below(Tetromino::type_count));
+
+				random.shuffle(_bag, size);
+				_remaining = size;
+			}
+		};
+
+		typedef Bag<1, 0> SevenBag;
+		typedef Bag<2, 0> FourteenBag;
+		typedef Bag<1, 1> SevenPlusOne;
+
+		/* TGM: rerolls pieces found in the last 4 dealt, up to 4 times. The first piece is never S, Z or O */
+		class History
+		{
+		public:
+			static constexpr int history_size = 4;
+			static constexpr int rolls = 4;
+
+		private:
+			Tetromino::Type _history[history_size] = { Tetromino::Type::Z, Tetromino::Type::Z, Tetromino::Type::Z, Tetromino::Type::Z };
+			bool _first = true;
+
+		public:
+			inline Tetromino::Type take(Random& random)
+			{
+				Tetromino::Type type;
+				if (_first)
+				{
+					static constexpr Tetromino::Type first_types[] = { Tetromino::Type::I, Tetromino::Type::T, Tetromino::Type::J, Tetromino::Type::L };
+					type = first_types[random.below(4)];
+					_first = false;
+				}
+				else
+				{
+					for (int roll = 0; roll < rolls; roll++)
+					{
+						type = static_cast<Tetromino::Type>(random.below(Tetromino::type_count));
+						if (!_inHistory(type))
+							break;
+					}
+				}
+
+				for (int i = history_size - 1; i > 0; i--)
+					_history[i] = _history[i - 1];
+				_history[0] = type;
+
+				return type;
+			}
+
+		private:
+			inline bool _inHistory(Tetromino::Type type) const
+			{
+				for (auto old : _history)
+					if (old == type)
+						return true;
+				return false;
+			}
+		};
+
+		class Uniform
+		{
+		public:
+			inline Tetromino::Type take(Random& random) { return static_cast<Tetromino::Type>(random.below(Tetromino::type_count)); }
+		};
+	}
+
+
+
+	/* Piece supply for one policy, resolved at compile time */
+	template<typename _Policy>
+	class Randomizer
+	{
+	private:
+		Random _random;
+		_Policy _policy;
+
+	public:
+		Randomizer(UInt64 seed = 0) : _random{ seed }, _policy{} {}
+		Randomizer(const Randomizer&) = default;
+		Randomizer(Randomizer&&) noexcept = default;
+		~Randomizer() = default;
+
+		Randomizer& operator= (const Randomizer&) = default;
+		Randomizer& operator= (Randomizer&&) noexcept = default;
+
+		inline Tetromino::Type take() { return _policy.take(_random); }
+
+		inline void generate(Tetromino::Type* types, Size count)
+		{
+			for (Size i = 0; i < count; i++)
+				types[i] = _policy.take(_random);
+		}
+
+		inline UInt64 seed() const { return _random.seed(); }
+	};
+
+	typedef Randomizer<randomizer::SevenBag> TetrominoBag;
+
+
+
+	/*
+	 * Randomizer chosen at run time, for game modes. The policy is resolved once per
+	 * generate call, so callers that fill buffers do not pay a dispatch per piece.
+	 */
+	class AnyRandomizer
+	{
+	private:
+		std::variant<
+			Randomizer<randomizer::SevenBag>,
+			Randomizer<randomizer::FourteenBag>,
+			Randomizer<randomizer::SevenPlusOne>,
+			Randomizer<randomizer::History>,
+			Randomizer<randomizer::Uniform>
+		> _randomizer;
+
+	public:
+		AnyRandomizer(RandomizerType type = RandomizerType::SevenBag, UInt64 seed = 0);
+		AnyRandomizer(const AnyRandomizer&) = default;
+		AnyRandomizer(AnyRandomizer&&) noexcept = default;
+		~AnyRandomizer() = default;
+
+		AnyRandomizer& operator= (const AnyRandomizer&) = default;
+		AnyRandomizer& operator= (AnyRandomizer&&) noexcept = default;
+
+		void generate(Tetromino::Type* types, Size count);
+
+		inline RandomizerType type() const { return static_cast<RandomizerType>(_randomizer.index()); }
+
+		inline UInt64 seed() const { return std::visit([](const auto& randomizer) { return randomizer.seed(); }, _randomizer); }
+	};
+}
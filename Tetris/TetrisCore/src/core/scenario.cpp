@@ -0,0 +1,630 @@
+#include "scenario.h"
+#include "trace.h"
+
+#include <set>
+#include <algorithm>
+
+
+namespace core
+{
+	void ActionRepeatManager::update(const Time& delta)
+	{
+		if (_action == ScenarioAction::None)
+			return;
+
+		/* Time past the delay charges the repeat, and a late repeat keeps its debt so the cadence does not drift */
+		Time remaining = delta;
+		if (_delay > Time::zero())
+		{
+			_delay -= remaining;
+			if (_delay >= Time::zero())
+				return;
+
+			remaining = -_delay;
+			_delay = Time::zero();
+		}
+		_speed -= remaining;
+	}
+
+	Time ActionRepeatManager::untilRepeat() const
+	{
+		if (_action == ScenarioAction::None)
+			return Time::max();
+		return _delay + std::max(_speed, Time::zero());
+	}
+
+	void ActionRepeatManager::registerAction(ScenarioAction action)
+	{
+		if (action == _action)
+			return;
+
+		_action = action;
+
+		if (action != ScenarioAction::None)
+		{
+			/* The press already moved once, without delay the first repeat waits a whole speed period */
+			_delay = _repeatDelay;
+			_speed = _repeatDelay > Time::zero() ? Time::zero() : _repeatSpeed;
+		}
+	}
+
+
+
+
+
+	void TetrominoScenarioInfo::set(const Tetromino& tetromino, MoveType moveType)
+	{
+		lastMove = moveType;
+		type = tetromino.type();
+		rotation = tetromino.rotationState();
+		kicks = 0;
+	}
+
+	void TetrominoScenarioInfo::registerDrop()
+	{
+		lastMove = MoveType::Drop;
+		kicks = 0;
+	}
+	void TetrominoScenarioInfo::registerHorizontal()
+	{
+		lastMove = MoveType::Horizontal;
+		kicks = 0;
+	}
+	void TetrominoScenarioInfo::registerRotate(RotationState rotation, unsigned int kicks)
+	{
+		lastMove = MoveType::Rotate;
+		this->rotation = rotation;
+		this->kicks = kicks;
+	}
+
+
+
+
+
+	Scenario::Scenario() : Scenario{ Random::randomSeed() } {}
+
+	Scenario::Scenario(UInt64 seed, RandomizerType randomizer) :
+		_field{},
+		_hold{},
+		_nextTetrominos{ seed, randomizer },
+		_currentTetromino{},
+		_ghostTetromino{},
+		_currentTetrominoState{ TetrominoState::None },
+		_spawnCount{ 0 },
+		_bottomRowToErase{ -1 },
+		_linesPerLevel{ 10 },
+		_startLevel{ 1 },
+		_currentLevel{ 1 },
+		_tetrominoInfo{},
+		_horizontalMoveRepeat{},
+		_gravity{},
+		_score{},
+		_state{ State::Running },
+		_actionQueue{},
+		_timedActions{},
+		_events{}
+	{
+		_gravity.setGravityLevel(1);
+	}
+
+	void Scenario::update(const Time& delta)
+	{
+		CORE_TRACE_ZONE("Scenario::update");
+
+		_events.clear();
+
+		if (_state == State::Running)
+		{
+			/* Timed inputs split the update, so each one acts on the state at its own time */
+			std::stable_sort(_timedActions.begin(), _timedActions.end(), [](const TimedAction& left, const TimedAction& right) { return left.time < right.time; });
+
+			Time elapsed = Time::zero();
+			for (const TimedAction& input : _timedActions)
+			{
+				const Time time = std::clamp(input.time, elapsed, delta);
+				if (time > elapsed)
+				{
+					_advance(time - elapsed);
+					elapsed = time;
+					if (_state != State::Running)
+						break;
+				}
+
+				switch (input.kind)
+				{
+					case TimedAction::Kind::Push: pushAction(input.action); break;
+					case TimedAction::Kind::Press: pressAction(input.action); break;
+					case TimedAction::Kind::Release: releaseAction(input.action); break;
+				}
+			}
+
+			if (_state == State::Running)
+				_advance(delta - elapsed);
+		}
+		_timedActions.clear();
+	}
+
+	void Scenario::snapshot(ScenarioSnapshot& snapshot) const
+	{
+		snapshot.field = _field;
+		snapshot.currentTetromino = _currentTetromino;
+		snapshot.ghostTetromino = _ghostTetromino;
+		snapshot.hasCurrentTetromino = hasCurrentTetromino();
+		snapshot.hasGhostTetromino = hasGhostTetromino();
+
+		snapshot.nextCount = 0;
+		for (Tetromino::Type type : _nextTetrominos.queue())
+			if (snapshot.nextCount < TetrominoManager::next_count)
+				snapshot.next[snapshot.nextCount++] = type;
+
+		snapshot.hold = _hold;
+		snapshot.score = _score;
+
+		snapshot.state = _state;
+		snapshot.tetrominoState = _currentTetrominoState;
+		snapshot.spawnCount = _spawnCount;
+	}
+
+	void Scenario::pressAction(ScenarioAction action)
+	{
+		if (_horizontalMoveRepeat.action() != action)
+		{
+			pushAction(action);
+			_horizontalMoveRepeat.registerAction(action);
+		}
+	}
+
+	void Scenario::releaseAction(ScenarioAction action)
+	{
+		if (_horizontalMoveRepeat.action() == action)
+			_horizontalMoveRepeat.releaseAction();
+	}
+
+	void Scenario::clearActions()
+	{
+		while (!_actionQueue.empty())
+			_actionQueue.pop();
+		_timedActions.clear();
+	}
+
+	void Scenario::_advance(Time delta)
+	{
+		_processActions();
+
+		/* Repeats of a held move happen when they are due inside the step, not at its start */
+		for (Time due = _horizontalMoveRepeat.untilRepeat(); due <= delta; due = _horizontalMoveRepeat.untilRepeat())
+		{
+			if (due > Time::zero())
+			{
+				_horizontalMoveRepeat.update(due);
+				_updateCurrentTetromino(due);
+				delta -= due;
+				if (_state != State::Running)
+					return;
+			}
+
+			if (_horizontalMoveRepeat.isInstant())
+			{
+				_shiftCurrentTetromino(_horizontalMoveRepeat.action() == Action::MoveLeft);
+				break;
+			}
+
+			_horizontalMoveRepeat.registerRepeat();
+			pushAction(_horizontalMoveRepeat.action());
+			_processActions();
+		}
+
+		_horizontalMoveRepeat.update(delta);
+		_updateCurrentTetromino(delta);
+
+		/* With instant repeat the piece stays against the wall, also after falling past an obstacle or spawning */
+		if (_state == State::Running && _horizontalMoveRepeat.isInstant() && _horizontalMoveRepeat.isRepeating())
+			_shiftCurrentTetromino(_horizontalMoveRepeat.action() == Action::MoveLeft);
+	}
+
+	void Scenario::_processActions()
+	{
+		CORE_TRACE_ZONE("Scenario::_processActions");
+
+		while (!_actionQueue.empty())
+		{
+			switch (_actionQueue.front())
+			{
+			case Action::MoveLeft:
+				_moveLeftTetromino();
+				break;
+
+			case Action::MoveRight:
+				_moveRightTetromino();
+				break;
+
+			case Action::RotateLeft:
+				_rotateLeftCurrentTetromino();
+				break;
+
+			case Action::RotateRight:
+				_rotateRightCurrentTetromino();
+				break;
+
+			case Action::Rotate180:
+				_rotate180CurrentTetromino();
+				break;
+
+			case Action::NormalDrop:
+				_gravity.setMode(GravityClock::Mode::Normal);
+				break;
+
+			case Action::SoftDrop:
+				_gravity.setMode(GravityClock::Mode::Soft);
+				break;
+
+			case Action::HardDrop:
+				_gravity.setMode(GravityClock::Mode::Hard);
+				break;
+
+			case Action::Hold:
+				_holdTetromino();
+				break;
+
+			default:
+				break;
+			}
+			_actionQueue.pop();
+		}
+	}
+
+	void Scenario::_updateCurrentTetromino(const Time& delta)
+	{
+		CORE_TRACE_ZONE("Scenario::_updateCurrentTetromino");
+
+		switch (_currentTetrominoState)
+		{
+			case TetrominoState::Dropping:
+				_gravity.updateWaiting(delta);
+				if (_gravity.mode() == GravityClock::Mode::Hard)
+					_hardDropCurrentTetromino();
+				else if (!_gravity.isWaiting())
+					_dropCurrentTetromino();
+				break;
+
+			case TetrominoState::Frozen:
+				_gravity.updateFreezing(delta);
+				if (!_gravity.isFrozen())
+				{
+					_insertTetromino();
+				}
+				break;
+
+			case TetrominoState::Inserting:
+				_gravity.updateInserting(delta);
+				if (!_gravity.isInserting())
+				{
+					_currentTetrominoState = TetrominoState::None;
+
+					if (_bottomRowToErase >= 0 && _bottomRowToErase < Field::rows)
+					{
+						_field.dropRows(_bottomRowToErase);
+						_emit(ScenarioEvent::DropAfterClear);
+					}
+					_bottomRowToErase = -1;
+
+					_checkLevel();
+
+					_hold.unlock();
+				}
+				break;
+
+			case TetrominoState::None:
+				_spawnTetromino(false);
+				break;
+		}
+	}
+
+	void Scenario::_spawnTetromino(bool useHold)
+	{
+		if (useHold)
+			_currentTetromino.build(_hold.type());
+		else _currentTetromino = _nextTetrominos.next();
+
+		/* Try to situate into origin, or a bit over it */
+		const int row = _field.spawnRow(_currentTetromino.type());
+		if (row < 0)
+		{
+			_currentTetrominoState = TetrominoState::None;
+			_state = State::GameOver;
+			return;
+		}
+		_currentTetromino.setPosition(row, Field::spawn_column);
+
+		_spawnCount++;
+		_gravity.reset();
+		_tetrominoInfo.set(_currentTetromino);
+		_currentTetrominoState = TetrominoState::Dropping;
+		_generateGhostTetromino();
+	}
+
+	void Scenario::_dropCurrentTetromino()
+	{
+		/* Every elapsed row is applied at once, the piece lands if it can not fall all of them */
+		const Int64 pending = _gravity.pendingDrops();
+		const Int64 distance = std::min<Int64>(pending, _field.dropDistance(_currentTetromino));
+		const bool landed = distance < pending;
+
+		_gravity.registerDrop(landed ? distance + 1 : distance);
+
+		if (distance > 0)
+		{
+			_currentTetromino.move(-static_cast<int>(distance), 0);
+			_tetrominoInfo.registerDrop();
+
+			if (_gravity.mode() == GravityClock::Mode::Soft)
+			{
+				_score.addSoftDropScore(static_cast<UInt64>(distance));
+				_emit(ScenarioEvent::TetrominoSoftDrop);
+			}
+		}
+
+		if (landed)
+		{
+			_currentTetrominoState = TetrominoState::Frozen;
+			_gravity.freeze();
+		}
+	}
+
+	void Scenario::_hardDropCurrentTetromino()
+	{
+		const int distance = _field.dropDistance(_currentTetromino);
+		if (distance > 0)
+		{
+			_currentTetromino.move(-distance, 0);
+			_tetrominoInfo.registerDrop();
+			_score.addHardDropScore(static_cast<UInt64>(distance));
+		}
+
+		_insertTetromino();
+		_emit(ScenarioEvent::TetrominoHardDrop);
+	}
+
+	void Scenario::_horizontalMoveTetromino(bool left)
+	{
+		if (_currentTetrominoState == TetrominoState::None || _currentTetrominoState == TetrominoState::Inserting)
+			return;
+
+		if (left)
+		{
+			if (_currentTetrominoFits(0, -1))
+			{
+				_currentTetromino.moveLeft();
+				_emit(ScenarioEvent::TetrominoMove);
+			}
+		}
+		else
+		{
+			if (_currentTetrominoFits(0, 1))
+			{
+				_currentTetromino.moveRight();
+				_emit(ScenarioEvent::TetrominoMove);
+			}
+		}
+
+		_tetrominoInfo.registerHorizontal();
+
+		_evaluateTetrominoStateAfterAction();
+	}
+
+	void Scenario::_shiftCurrentTetromino(bool left)
+	{
+		if (_currentTetrominoState == TetrominoState::None || _currentTetrominoState == TetrominoState::Inserting)
+			return;
+
+		/* Resting against the wall is not a move, so it does not spoil a T-spin made there */
+		const int distance = _field.shiftDistance(_currentTetromino, left);
+		if (distance < 1)
+			return;
+
+		_currentTetromino.move(0, left ? -distance : distance);
+		_emit(ScenarioEvent::TetrominoMove);
+
+		_tetrominoInfo.registerHorizontal();
+
+		_evaluateTetrominoStateAfterAction();
+	}
+
+	void Scenario::_rotateCurrentTetromino(int turns)
+	{
+		if (_currentTetrominoState == TetrominoState::None || _currentTetrominoState == TetrominoState::Inserting)
+			return;
+
+		const Tetromino::Type type = _currentTetromino.type();
+		const RotationState from = _currentTetromino.rotationState();
+		const RotationState to = from + turns;
+		const auto& shape = Tetromino::shape(type, to);
+		const auto& kicks = Tetromino::kicks(type, from, to);
+
+		unsigned int kickId = 0;
+		for (; kickId < static_cast<unsigned int>(kicks.count); kickId++)
+		{
+			const int row = _currentTetromino.row() + kicks.tries[kickId].y;
+			const int column = _currentTetromino.column() + kicks.tries[kickId].x;
+			if (_field.fits(shape, row, column))
+			{
+				_currentTetromino.setRotationState(to);
+				_currentTetromino.setPosition(row, column);
+				_emit(ScenarioEvent::TetrominoRotate);
+				break;
+			}
+		}
+
+		_tetrominoInfo.registerRotate(_currentTetromino.rotationState(), kickId);
+
+		_evaluateTetrominoStateAfterAction();
+	}
+
+	void Scenario::_holdTetromino()
+	{
+		if (_currentTetrominoState != TetrominoState::Dropping || _hold.isLock())
+			return;
+
+		if (_hold.empty())
+		{
+			_hold.hold(_currentTetromino);
+			_spawnTetromino(false);
+		}
+		else
+		{
+			Tetromino::Type type = _currentTetromino.type();
+			_spawnTetromino(true);
+			_hold.hold(type);
+		}
+
+		_emit(ScenarioEvent::TetrominoHold);
+	}
+
+	void Scenario::_evaluateTetrominoStateAfterAction()
+	{
+		if (_currentTetrominoState == TetrominoState::Frozen)
+		{
+			if (_currentTetrominoFits(-1, 0))
+			{
+				_currentTetrominoState = TetrominoState::Dropping;
+				_gravity.reset();
+				_generateGhostTetromino();
+			}
+			else _gravity.freeze();
+		}
+		else if(_currentTetrominoState == TetrominoState::Dropping)
+			_generateGhostTetromino();
+	}
+
+	void Scenario::_generateGhostTetromino()
+	{
+		_ghostTetromino = _currentTetromino;
+
+		_ghostTetromino.move(-_field.dropDistance(_currentTetromino), 0);
+	}
+
+	void Scenario::_insertTetromino()
+	{
+		_currentTetrominoState = TetrominoState::Inserting;
+
+		_field.insert(_currentTetromino);
+		if (_eraseCompleteLines())
+			_gravity.erasingInsertion();
+		else
+		{
+			_gravity.insertion();
+			_emit(ScenarioEvent::TetrominoHit);
+		}
+	}
+
+	unsigned int Scenario::_eraseCompleteLines()
+	{
+		auto cells = _currentTetromino.cellsAsVector();
+		std::set<int> lines;
+		for (const auto& cell : cells)
+			lines.insert(cell.y);
+
+		int erased = 0, bottomLine = Field::rows;
+		for (int line : lines)
+			if (_field.eraseIfComplete(line))
+			{
+				bottomLine = line < bottomLine ? line : bottomLine;
+				erased++;
+			}
+
+		_bottomRowToErase = erased > 0 ? bottomLine : -1;
+
+		_score.addLines(static_cast<UInt64>(erased));
+
+		if (_tetrominoInfo.type == Tetromino::Type::T &&
+			_tetrominoInfo.lastMove == TetrominoScenarioInfo::MoveType::Rotate &&
+			_field.TSlotCorners(_currentTetromino) > 2)
+		{
+			erased = erased < 0 ? 0 : erased;
+
+			if (_tetrominoInfo.kicks > 0 && _tetrominoInfo.kicks < 3)
+			{
+				switch (erased)
+				{
+					case 0: _score.addTSpinMiniNoLinesScore(); break;
+					case 1: _score.addTSpinMiniSingleScore(), _emit(ScenarioEvent::SingleLine); break;
+					case 2: _score.addTSpinMiniDoubleScore(), _emit(ScenarioEvent::DoubleLine); break;
+					case 3:
+					default: _score.addTSpinTripleScore(), _emit(ScenarioEvent::TripleLine); break;
+				}
+				_emit(ScenarioEvent::SpecialClear);
+			}
+			else
+			{
+				switch (erased)
+				{
+					case 0: _score.addTSpinNoLinesScore(); break;
+					case 1: _score.addTSpinSingleScore(), _emit(ScenarioEvent::SingleLine); break;
+					case 2: _score.addTSpinDoubleScore(), _emit(ScenarioEvent::DoubleLine); break;
+					case 3:
+					default: _score.addTSpinTripleScore(), _emit(ScenarioEvent::TripleLine); break;
+				}
+			}
+		}
+		else if (erased > 0)
+		{
+			switch (erased)
+			{
+				case 1: _score.addSingleScore(), _emit(ScenarioEvent::SingleLine); break;
+				case 2: _score.addDoubleScore(), _emit(ScenarioEvent::DoubleLine); break;
+				case 3: _score.addTripleScore(), _emit(ScenarioEvent::TripleLine); break;
+				case 4:
+				default: _score.addTetrisScore(), _emit(ScenarioEvent::TetrisLine); break;
+			}
+		}
+
+		return static_cast<unsigned int>(erased);
+	}
+
+	void Scenario::setStartLevel(unsigned int level)
+	{
+		_startLevel = std::max(1U, level);
+		_currentLevel = 0;
+		_checkLevel();
+	}
+
+	void Scenario::_checkLevel()
+	{
+		unsigned int level = (static_cast<unsigned int>(_score.lines() / static_cast<UInt64>(_linesPerLevel)) + _startLevel);
+		if (level != _currentLevel)
+		{
+			_currentLevel = level;
+			_gravity.setGravityLevel(level);
+			_score.setLevel(level);
+		}
+	}
+
+
+
+	static inline bool same_tetromino(const Tetromino& left, const Tetromino& right)
+	{
+		return left.type() == right.type() && left.rotationState() == right.rotationState() && left.getPosition() == right.getPosition();
+	}
+
+	bool ScenarioSnapshot::sameView(const ScenarioSnapshot& other) const
+	{
+		if (field.revision() != other.field.revision() || state != other.state || tetrominoState != other.tetrominoState)
+			return false;
+
+		if (hasCurrentTetromino != other.hasCurrentTetromino || (hasCurrentTetromino && !same_tetromino(currentTetromino, other.currentTetromino)))
+			return false;
+		if (hasGhostTetromino != other.hasGhostTetromino || (hasGhostTetromino && !same_tetromino(ghostTetromino, other.ghostTetromino)))
+			return false;
+
+		if (nextCount != other.nextCount)
+			return false;
+		for (unsigned int i = 0; i < nextCount; i++)
+			if (next[i] != other.next[i])
+				return false;
+
+		if (hold.empty() != other.hold.empty() || hold.isLock() != other.hold.isLock() || (!hold.empty() && hold.type() != other.hold.type()))
+			return false;
+
+		return score.points() == other.score.points() && score.lines() == other.score.lines() && score.level() == other.score.level();
+	}
+}
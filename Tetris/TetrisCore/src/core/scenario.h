@@ -0,0 +1,309 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+
+#include "field.h"
+#include "gravity.h"
+#include "tetromino_manager.h"
+#include "score.h"
+
+
+namespace core
+{
+	enum class ScenarioAction
+	{
+		None,
+		MoveLeft,
+		MoveRight,
+		RotateLeft,
+		RotateRight,
+		Rotate180,
+		NormalDrop,
+		SoftDrop,
+		HardDrop,
+		Hold
+	};
+
+
+
+	/* Notifications raised by the rules during an update. Presenters use them to play sounds */
+	enum class ScenarioEvent
+	{
+		SingleLine,
+		DoubleLine,
+		TripleLine,
+		TetrisLine,
+		SpecialClear,
+
+		DropAfterClear,
+
+		TetrominoMove,
+		TetrominoRotate,
+		TetrominoHold,
+		TetrominoHit,
+		TetrominoSoftDrop,
+		TetrominoHardDrop
+	};
+
+
+
+	class ActionRepeatManager
+	{
+	public:
+		static constexpr Int64 auto_repeat_delay = static_cast<Int64>(170 * 1000); /* 170 milliseconds */
+		static constexpr Int64 auto_repeat_speed = static_cast<Int64>(50 * 1000); /* 50 milliseconds */
+
+	private:
+		Time _delay = Time::zero();
+		Time _speed = Time::zero();
+		ScenarioAction _action = ScenarioAction::None;
+
+		Time _repeatDelay = Time{ auto_repeat_delay };
+		Time _repeatSpeed = Time{ auto_repeat_speed };
+
+	public:
+		ActionRepeatManager() = default;
+		ActionRepeatManager(const ActionRepeatManager&) = default;
+		ActionRepeatManager(ActionRepeatManager&&) noexcept = default;
+		~ActionRepeatManager() = default;
+
+		ActionRepeatManager& operator= (const ActionRepeatManager&) = default;
+		ActionRepeatManager& operator= (ActionRepeatManager&&) noexcept = default;
+
+		void update(const Time& delta);
+
+		void registerAction(ScenarioAction action);
+
+		/* Time left for the next repeat, zero when it is due and max when nothing is held */
+		Time untilRepeat() const;
+
+		inline void releaseAction() { registerAction(ScenarioAction::None); }
+
+		inline bool isRepeating() const { return _action != ScenarioAction::None && _delay <= Time::zero(); }
+		inline bool isWaiting() const { return _action == ScenarioAction::None || _speed > Time::zero(); }
+		inline void registerRepeat() { _speed += _repeatSpeed; }
+		inline ScenarioAction action() const { return _action; }
+
+		/* DAS and ARR. A zero speed means a charged direction goes straight to the wall */
+		inline void setTiming(const Time& delay, const Time& speed)
+		{
+			_repeatDelay = std::max(delay, Time::zero());
+			_repeatSpeed = std::max(speed, Time::zero());
+		}
+		inline const Time& repeatDelay() const { return _repeatDelay; }
+		inline const Time& repeatSpeed() const { return _repeatSpeed; }
+		inline bool isInstant() const { return _repeatSpeed == Time::zero(); }
+	};
+
+
+
+	struct TetrominoScenarioInfo
+	{
+	public:
+		enum class MoveType { Drop, Horizontal, Rotate };
+
+	public:
+		MoveType lastMove = MoveType::Drop;
+		Tetromino::Type type = Tetromino::Type::I;
+		RotationState rotation;
+		unsigned int kicks = 0;
+
+		TetrominoScenarioInfo() = default;
+		TetrominoScenarioInfo(const TetrominoScenarioInfo&) = default;
+		TetrominoScenarioInfo(TetrominoScenarioInfo&&) noexcept = default;
+		~TetrominoScenarioInfo() = default;
+
+		TetrominoScenarioInfo& operator= (const TetrominoScenarioInfo&) = default;
+		TetrominoScenarioInfo& operator= (TetrominoScenarioInfo&&) noexcept = default;
+
+		void set(const Tetromino& tetromino, MoveType moveType = MoveType::Drop);
+		void registerDrop();
+		void registerHorizontal();
+		void registerRotate(RotationState rotation, unsigned int kicks);
+	};
+
+
+
+	struct ScenarioSnapshot;
+
+	class Scenario
+	{
+	public:
+		enum class State { Running, GameOver };
+		enum class TetrominoState { None, Dropping, Frozen, Inserting };
+
+	private:
+		using Action = ScenarioAction;
+
+		struct TimedAction
+		{
+			enum class Kind { Push, Press, Release };
+
+			Time time;
+			ScenarioAction action;
+			Kind kind;
+		};
+
+	private:
+		Field _field;
+
+		HoldManager _hold;
+		TetrominoManager _nextTetrominos;
+		Tetromino _currentTetromino;
+		Tetromino _ghostTetromino;
+		TetrominoState _currentTetrominoState;
+		UInt64 _spawnCount;
+
+		int _bottomRowToErase;
+
+		unsigned int _linesPerLevel;
+		unsigned int _startLevel;
+		unsigned int _currentLevel;
+
+		TetrominoScenarioInfo _tetrominoInfo;
+
+		ActionRepeatManager _horizontalMoveRepeat;
+
+		GravityClock _gravity;
+
+		Score _score;
+
+		State _state;
+
+		std::queue<ScenarioAction> _actionQueue;
+		std::vector<TimedAction> _timedActions;
+
+		std::vector<ScenarioEvent> _events;
+
+	public:
+		Scenario();
+		explicit Scenario(UInt64 seed, RandomizerType randomizer = RandomizerType::SevenBag);
+		Scenario(const Scenario&) = default;
+		Scenario(Scenario&&) noexcept = default;
+		~Scenario() = default;
+
+		Scenario& operator= (const Scenario&) = default;
+		Scenario& operator= (Scenario&&) noexcept = default;
+
+		inline State state() const { return _state; }
+
+		inline const Field& field() const { return _field; }
+		inline const TetrominoManager& nextTetrominoManager() const { return _nextTetrominos; }
+		inline const HoldManager& holdManager() const { return _hold; }
+		inline const Score& score() const { return _score; }
+
+		/* Seed of the piece sequence. Scenarios with the same seed get the same pieces */
+		inline UInt64 seed() const { return _nextTetrominos.seed(); }
+
+		inline RandomizerType randomizerType() const { return _nextTetrominos.randomizerType(); }
+
+		inline const Tetromino& currentTetromino() const { return _currentTetromino; }
+		inline const Tetromino& ghostTetromino() const { return _ghostTetromino; }
+		inline TetrominoState tetrominoState() const { return _currentTetrominoState; }
+
+		/* Tetrominos spawned so far, including the ones taken from hold */
+		inline UInt64 spawnCount() const { return _spawnCount; }
+
+		inline bool hasCurrentTetromino() const
+		{
+			return _currentTetrominoState != TetrominoState::None && _currentTetrominoState != TetrominoState::Inserting;
+		}
+		inline bool hasGhostTetromino() const { return _currentTetrominoState == TetrominoState::Dropping; }
+
+		/* Events raised during the last update call */
+		inline const std::vector<ScenarioEvent>& events() const { return _events; }
+
+		inline void setLevel(unsigned int level) { _gravity.setGravityLevel(level); }
+
+		/* Level of the game before any line is cleared: gravity, score multiplier and the base of later levels */
+		void setStartLevel(unsigned int level);
+		inline unsigned int startLevel() const { return _startLevel; }
+
+		inline void pushAction(ScenarioAction action) { _actionQueue.push(action); }
+
+		/* Auto repeat of held horizontal moves: delay before it starts (DAS) and time between moves (ARR), both can be zero */
+		inline void setAutoRepeat(const Time& delay, const Time& speed) { _horizontalMoveRepeat.setTiming(delay, speed); }
+		inline const ActionRepeatManager& autoRepeat() const { return _horizontalMoveRepeat; }
+
+	public:
+		void update(const Time& delta);
+
+		/* Copies everything needed to draw the scenario, without allocating */
+		void snapshot(ScenarioSnapshot& snapshot) const;
+
+		/* Press and release of a repeatable (horizontal) action, as done by a held key */
+		void pressAction(ScenarioAction action);
+		void releaseAction(ScenarioAction action);
+
+		/* Inputs that happen time into the next update. They are applied at that point of it, not at its start */
+		inline void pushAction(ScenarioAction action, const Time& time) { _timedActions.push_back({ time, action, TimedAction::Kind::Push }); }
+		inline void pressAction(ScenarioAction action, const Time& time) { _timedActions.push_back({ time, action, TimedAction::Kind::Press }); }
+		inline void releaseAction(ScenarioAction action, const Time& time) { _timedActions.push_back({ time, action, TimedAction::Kind::Release }); }
+
+		void clearActions();
+
+	private:
+		void _advance(Time delta);
+		void _processActions();
+		void _updateCurrentTetromino(const Time& delta);
+
+		void _spawnTetromino(bool useHold);
+		void _dropCurrentTetromino();
+		void _hardDropCurrentTetromino();
+		void _horizontalMoveTetromino(bool left);
+		void _shiftCurrentTetromino(bool left);
+		void _rotateCurrentTetromino(int turns);
+		void _holdTetromino();
+
+		void _evaluateTetrominoStateAfterAction();
+
+		void _generateGhostTetromino();
+
+		void _insertTetromino();
+
+		unsigned int _eraseCompleteLines();
+
+		void _checkLevel();
+
+	private:
+		inline void _moveLeftTetromino() { _horizontalMoveTetromino(true); }
+		inline void _moveRightTetromino() { _horizontalMoveTetromino(false); }
+
+		inline void _rotateLeftCurrentTetromino() { _rotateCurrentTetromino(-1); }
+		inline void _rotateRightCurrentTetromino() { _rotateCurrentTetromino(1); }
+		inline void _rotate180CurrentTetromino() { _rotateCurrentTetromino(2); }
+
+		inline bool _currentTetrominoFits(int rowOffset, int columnOffset) const
+		{
+			return _field.fits(_currentTetromino.type(), _currentTetromino.rotationState(), _currentTetromino.row() + rowOffset, _currentTetromino.column() + columnOffset);
+		}
+
+		inline void _emit(ScenarioEvent event) { _events.push_back(event); }
+	};
+
+
+
+	/* Plain copy of the visible scenario state, for readers on other threads */
+	struct ScenarioSnapshot
+	{
+		Field field;
+		Tetromino currentTetromino;
+		Tetromino ghostTetromino;
+		bool hasCurrentTetromino = false;
+		bool hasGhostTetromino = false;
+
+		Tetromino::Type next[TetrominoManager::next_count] = {};
+		unsigned int nextCount = 0;
+
+		HoldManager hold;
+		Score score;
+
+		Scenario::State state = Scenario::State::Running;
+		Scenario::TetrominoState tetrominoState = Scenario::TetrominoState::None;
+		UInt64 spawnCount = 0;
+
+		/* True when both snapshots would be drawn the same. The field is compared by its revision */
+		bool sameView(const ScenarioSnapshot& other) const;
+	};
+}
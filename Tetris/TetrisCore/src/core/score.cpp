@@ -0,0 +1,38 @@
+#include "score.h"
+
+
+namespace core
+{
+	Score::Score() :
+		_points{ 0 },
+		_lines{ 0 },
+		_level{ 1 },
+		_backToBack{ false }
+	{}
+
+	void Score::addLines(UInt64 amount)
+	{
+		_lines += amount;
+	}
+
+	void Score::setLevel(unsigned int level)
+	{
+		_level = level < 1 ? 1 : level;
+	}
+
+	void Score::_increasePoints(UInt64 amount)
+	{
+		_points += amount;
+	}
+
+	void Score::_increasePointsFromBase(int base, bool difficult)
+	{
+		if (difficult && _backToBack)
+			base = base * 3 / 2;
+
+		_backToBack = difficult;
+
+		UInt64 amount = static_cast<UInt64>(base) * static_cast<UInt64>(_level);
+		_points += amount;
+	}
+}
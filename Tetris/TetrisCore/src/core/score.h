@@ -0,0 +1,56 @@
+#pragma once
+
+#include "basics.h"
+
+
+namespace core
+{
+	class Score
+	{
+	private:
+		UInt64 _points;
+		UInt64 _lines;
+		unsigned int _level;
+
+		bool _backToBack;
+
+	public:
+		Score();
+		Score(const Score&) = default;
+		Score(Score&&) noexcept = default;
+		~Score() = default;
+
+		Score& operator= (const Score&) = default;
+		Score& operator= (Score&&) noexcept = default;
+
+		void addLines(UInt64 amount);
+
+		void setLevel(unsigned int level);
+
+		inline UInt64 points() const { return _points; }
+		inline UInt64 lines() const { return _lines; }
+		inline unsigned int level() const { return _level; }
+		inline bool hasBackToBack() const { return _backToBack; }
+
+		inline void addSingleScore() { _increasePointsFromBase(100, false); }
+		inline void addDoubleScore() { _increasePointsFromBase(300, false); }
+		inline void addTripleScore() { _increasePointsFromBase(500, false); }
+		inline void addTetrisScore() { _increasePointsFromBase(800, true); }
+
+		inline void addTSpinMiniNoLinesScore() { _increasePointsFromBase(100, false); }
+		inline void addTSpinMiniSingleScore() { _increasePointsFromBase(200, true); }
+		inline void addTSpinMiniDoubleScore() { _increasePointsFromBase(400, true); }
+
+		inline void addTSpinNoLinesScore() { _increasePointsFromBase(400, false); }
+		inline void addTSpinSingleScore() { _increasePointsFromBase(400, true); }
+		inline void addTSpinDoubleScore() { _increasePointsFromBase(1200, true); }
+		inline void addTSpinTripleScore() { _increasePointsFromBase(1600, true); }
+
+		inline void addSoftDropScore(UInt64 rows = 1) { _increasePoints(rows); }
+		inline void addHardDropScore(UInt64 rows = 1) { _increasePoints(2 * rows); }
+
+	private:
+		void _increasePoints(UInt64 amount);
+		void _increasePointsFromBase(int base, bool difficult);
+	};
+}
@@ -0,0 +1,34 @@
+#include "tetromino.h"
+
+#include "field.h"
+
+
+namespace core
+{
+	void Tetromino::moveToOrigin() { setPosition(Field::rows - 1, 0); }
+
+	void Tetromino::kick(RotationState prevState, unsigned int tryId)
+	{
+		auto offset = kickOffset(_type, prevState, _rotation, tryId);
+		move(offset.y, offset.x);
+	}
+
+	std::array<int, 4> Tetromino::cellsIndex() const
+	{
+		const auto& cells = shape().cells;
+		const int base = (_row * Field::columns) + _column;
+		return {
+			base + (cells[0].y * Field::columns) + cells[0].x,
+			base + (cells[1].y * Field::columns) + cells[1].x,
+			base + (cells[2].y * Field::columns) + cells[2].x,
+			base + (cells[3].y * Field::columns) + cells[3].x
+		};
+	}
+
+	std::array<Point, 4> Tetromino::cellsAsVector() const
+	{
+		const auto& cells = shape().cells;
+		const Point position = getPosition();
+		return { position + cells[0], position + cells[1], position + cells[2], position + cells[3] };
+	}
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "kicks.h"
+
+
+namespace core
+{
+	struct RotationState
+	{
+		static constexpr int Origin = 0;
+		static constexpr int Right = 1;
+		static constexpr int Inverse = 2;
+		static constexpr int Left = 3;
+
+		int state;
+
+		constexpr RotationState() : state{ Origin } {}
+		constexpr RotationState(int state) : state{ utils::clamp(state, Origin, Left) } {}
+
+		inline bool isOrigin() { return state == Origin; }
+		inline bool isRight() { return state == Right; }
+		inline bool isInverse() { return state == Inverse; }
+		inline bool isLeft() { return state == Left; }
+
+		static constexpr RotationState origin() { return Origin; }
+		static constexpr RotationState right() { return Right; }
+		static constexpr RotationState inverse() { return Inverse; }
+		static constexpr RotationState left() { return Left; }
+
+		static constexpr bool isOrigin(RotationState state) { return state.state == Origin; }
+		static constexpr bool isRight(RotationState state) { return state.state == Right; }
+		static constexpr bool isInverse(RotationState state) { return state.state == Inverse; }
+		static constexpr bool isLeft(RotationState state) { return state.state == Left; }
+	};
+
+	constexpr RotationState& operator++ (RotationState& state)
+	{
+		return (state.state = state.state == RotationState::Left ? RotationState::Origin : state.state + 1), state;
+	}
+	constexpr RotationState operator++ (RotationState& state, int)
+	{
+		RotationState copy = state;
+		return ++state, copy;
+	}
+
+	constexpr RotationState& operator-- (RotationState& state)
+	{
+		return (state.state = state.state == RotationState::Origin ? RotationState::Left : state.state - 1), state;
+	}
+	constexpr RotationState operator-- (RotationState& state, int)
+	{
+		RotationState copy = state;
+		return --state, copy;
+	}
+
+	constexpr RotationState operator+ (RotationState state, int turns)
+	{
+		return ((state.state + turns) % 4 + 4) % 4;
+	}
+
+	constexpr bool operator== (RotationState left, RotationState right) { return left.state == right.state; }
+	constexpr bool operator!= (RotationState left, RotationState right) { return left.state != right.state; }
+
+
+
+	/*
+	 * Minos of a tetromino for one rotation state, relative to its 4x4 box.
+	 * cells hold { column, row } offsets and rows hold the occupancy mask of each box row.
+	 * bottoms hold the lowest occupied row of each box column, or box_size if the column is empty.
+	 */
+	struct TetrominoShape
+	{
+		static constexpr int box_size = 4;
+		static constexpr int mino_count = 4;
+
+		Point cells[mino_count] = {};
+		UInt16 rows[box_size] = {};
+		Int8 bottoms[box_size] = { box_size, box_size, box_size, box_size };
+	};
+
+	namespace geometry
+	{
+		/* Spawn shapes, indexed as Tetromino::Type (I, O, T, J, L, S, Z) */
+		constexpr Point spawn_cells[][TetrominoShape::mino_count] = {
+			{ { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 2 } }, // I //
+			{ { 1, 1 }, { 2, 1 }, { 1, 2 }, { 2, 2 } }, // O //
+			{ { 0, 1 }, { 1, 1 }, { 2, 1 }, { 1, 2 } }, // T //
+			{ { 0, 1 }, { 1, 1 }, { 2, 1 }, { 0, 2 } }, // J //
+			{ { 0, 1 }, { 1, 1 }, { 2, 1 }, { 2, 2 } }, // L //
+			{ { 0, 1 }, { 1, 1 }, { 1, 2 }, { 2, 2 } }, // S //
+			{ { 1, 1 }, { 2, 1 }, { 0, 2 }, { 1, 2 } }  // Z //
+		};
+
+		constexpr CellColor colors[] = {
+			CellColor::Cyan,
+			CellColor::Yellow,
+			CellColor::Purple,
+			CellColor::Blue,
+			CellColor::Orange,
+			CellColor::Green,
+			CellColor::Red
+		};
+
+		constexpr int type_count = static_cast<int>(sizeof(spawn_cells) / sizeof(spawn_cells[0]));
+		constexpr int rotation_count = 4;
+
+		/* I rotates inside the whole 4x4 box, O does not rotate and the rest rotate inside the lower 3x3 box */
+		constexpr int rotation_box(int type) { return type == 0 ? 4 : type == 1 ? 0 : 3; }
+
+		constexpr TetrominoShape make_shape(int type, int rotation)
+		{
+			TetrominoShape shape;
+			const int box = rotation_box(type);
+
+			for (int i = 0; i < TetrominoShape::mino_count; i++)
+			{
+				Point cell = spawn_cells[type][i];
+				if (box > 0)
+				{
+					/* Clockwise rotation: (column, row) -> (row, box - 1 - column) */
+					for (int r = 0; r < rotation; r++)
+						cell = { cell.y, box - 1 - cell.x };
+				}
+				shape.cells[i] = cell;
+				shape.rows[cell.y] |= static_cast<UInt16>(0x1 << cell.x);
+				if (cell.y < shape.bottoms[cell.x])
+					shape.bottoms[cell.x] = static_cast<Int8>(cell.y);
+			}
+
+			/* Keep the minos sorted by row and column */
+			for (int i = 1; i < TetrominoShape::mino_count; i++)
+				for (int j = i; j > 0 && (shape.cells[j].y < shape.cells[j - 1].y ||
+					(shape.cells[j].y == shape.cells[j - 1].y && shape.cells[j].x < shape.cells[j - 1].x)); j--)
+				{
+					Point tmp = shape.cells[j];
+					shape.cells[j] = shape.cells[j - 1];
+					shape.cells[j - 1] = tmp;
+				}
+
+			return shape;
+		}
+
+		constexpr std::array<std::array<TetrominoShape, rotation_count>, type_count> make_shapes()
+		{
+			std::array<std::array<TetrominoShape, rotation_count>, type_count> shapes;
+			for (int type = 0; type < type_count; type++)
+				for (int rotation = 0; rotation < rotation_count; rotation++)
+					shapes[type][rotation] = make_shape(type, rotation);
+			return shapes;
+		}
+
+		constexpr auto shapes = make_shapes();
+
+		constexpr bool same_rows(const TetrominoShape& shape, UInt16 r0, UInt16 r1, UInt16 r2, UInt16 r3)
+		{
+			return shape.rows[0] == r0 && shape.rows[1] == r1 && shape.rows[2] == r2 && shape.rows[3] == r3;
+		}
+
+		/* Row masks: bit n is column n, rows go from bottom to top */
+		static_assert(same_rows(shapes[0][0], 0b0000, 0b0000, 0b1111, 0b0000), "I origin");
+		static_assert(same_rows(shapes[0][1], 0b0100, 0b0100, 0b0100, 0b0100), "I right");
+		static_assert(same_rows(shapes[0][2], 0b0000, 0b1111, 0b0000, 0b0000), "I inverse");
+		static_assert(same_rows(shapes[0][3], 0b0010, 0b0010, 0b0010, 0b0010), "I left");
+		static_assert(same_rows(shapes[1][3], 0b0000, 0b0110, 0b0110, 0b0000), "O never rotates");
+		static_assert(same_rows(shapes[2][0], 0b0000, 0b0111, 0b0010, 0b0000), "T origin");
+		static_assert(same_rows(shapes[2][1], 0b0010, 0b0110, 0b0010, 0b0000), "T right");
+		static_assert(same_rows(shapes[2][2], 0b0010, 0b0111, 0b0000, 0b0000), "T inverse");
+		static_assert(same_rows(shapes[2][3], 0b0010, 0b0011, 0b0010, 0b0000), "T left");
+		static_assert(same_rows(shapes[3][1], 0b0010, 0b0010, 0b0110, 0b0000), "J right");
+		static_assert(same_rows(shapes[4][1], 0b0110, 0b0010, 0b0010, 0b0000), "L right");
+		static_assert(same_rows(shapes[5][1], 0b0100, 0b0110, 0b0010, 0b0000), "S right");
+		static_assert(same_rows(shapes[6][1], 0b0010, 0b0110, 0b0100, 0b0000), "Z right");
+	}
+
+
+
+	class Tetromino
+	{
+	public:
+		enum class Type { I, O, T, J, L, S, Z };
+
+	public:
+		static constexpr int rows = 4;
+		static constexpr int columns = 4;
+		static constexpr int type_count = static_cast<int>(Type::Z) + 1;
+
+		static constexpr int max_rotation_try = geometry::max_kick_tries;
+
+		static_assert(type_count == geometry::type_count);
+
+	private:
+		int _row = 0;
+		int _column = 0;
+		Type _type = Type::I;
+		RotationState _rotation = RotationState::origin();
+
+	public:
+		Tetromino() = default;
+		Tetromino(const Tetromino&) = default;
+		Tetromino(Tetromino&&) noexcept = default;
+		~Tetromino() = default;
+
+		Tetromino& operator= (const Tetromino&) = default;
+		Tetromino& operator= (Tetromino&&) noexcept = default;
+
+		void moveToOrigin();
+
+		void kick(RotationState prevState, unsigned int tryId);
+
+		std::array<int, 4> cellsIndex() const;
+		std::array<Point, 4> cellsAsVector() const;
+
+	public:
+		inline void build(Type type) { _type = type, _rotation = RotationState::Origin; }
+
+		inline void setPosition(int row, int column) { _row = row, _column = column; }
+		inline void move(int rowDelta, int columnDelta) { _row += rowDelta, _column += columnDelta; }
+
+		inline void leftRotate() { --_rotation; }
+		inline void rightRotate() { ++_rotation; }
+		inline void setRotationState(RotationState rotation) { _rotation = rotation; }
+
+		inline void moveDown() { move(-1, 0); }
+		inline void moveLeft() { move(0, -1); }
+		inline void moveRight() { move(0, 1); }
+
+		inline int row() const { return _row; }
+		inline int column() const { return _column; }
+		inline Point getPosition() const { return { _column, _row }; }
+
+		inline Type type() const { return _type; }
+
+		inline RotationState rotationState() const { return _rotation; }
+
+		inline const TetrominoShape& shape() const { return shape(_type, _rotation); }
+
+		inline CellColor color() const { return color(_type); }
+
+		inline CellColor cell(int row, int column) const
+		{
+			return (shape().rows[utils::clamp(row, 0, rows - 1)] >> utils::clamp(column, 0, columns - 1)) & 0x1 ? color() : CellColor::Empty;
+		}
+
+		static constexpr const TetrominoShape& shape(Type type, RotationState rotation)
+		{
+			return geometry::shapes[static_cast<int>(type)][rotation.state];
+		}
+
+		static constexpr CellColor color(Type type) { return geometry::colors[static_cast<int>(type)]; }
+
+		static constexpr const geometry::KickData& kicks(Type type, RotationState from, RotationState to)
+		{
+			return geometry::kicks[static_cast<int>(geometry::kick_class(static_cast<int>(type)))][from.state][to.state];
+		}
+
+		/* Translation, as { column, row }, of the kick test tryId when rotating from one state to another */
+		static constexpr Point kickOffset(Type type, RotationState from, RotationState to, unsigned int tryId)
+		{
+			const auto& data = kicks(type, from, to);
+			return tryId < static_cast<unsigned int>(data.count) ? data.tries[tryId] : Point{};
+		}
+
+		inline Tetromino(Type type) : Tetromino() { build(type); }
+	};
+}
@@ -0,0 +1,75 @@
+#include "tetromino_manager.h"
+
+
+namespace core
+{
+	TetrominoManager::TetrominoManager(UInt64 seed, RandomizerType randomizer) :
+		_randomizer{ randomizer, seed },
+		_buffer{},
+		_bufferSize{ 0 },
+		_bufferNext{ 0 },
+		_next{}
+	{
+		for (int i = 0; i < TetrominoManager::next_count; i++)
+			generate();
+	}
+
+	Tetromino TetrominoManager::next()
+	{
+		generate();
+
+		Tetromino next{ _next.front() };
+		_next.pop_front();
+
+		next.setPosition(0, 0);
+
+		return next;
+	}
+
+	void TetrominoManager::upcoming(Tetromino::Type* types, Size count) const
+	{
+		Size written = 0;
+		for (auto it = _next.begin(); it != _next.end() && written < count; ++it)
+			types[written++] = *it;
+		for (unsigned int i = _bufferNext; i < _bufferSize && written < count; i++)
+			types[written++] = _buffer[i];
+
+		if (written < count)
+		{
+			AnyRandomizer randomizer{ _randomizer };
+			randomizer.generate(types + written, count - written);
+		}
+	}
+
+	void TetrominoManager::generate()
+	{
+		/* Refill a whole chunk at once, so the policy is resolved once per buffer_size pieces */
+		if (_bufferNext >= _bufferSize)
+		{
+			_randomizer.generate(_buffer, buffer_size);
+			_bufferSize = buffer_size;
+			_bufferNext = 0;
+		}
+		_next.push_back(_buffer[_bufferNext++]);
+	}
+
+
+
+
+
+	HoldManager::HoldManager() :
+		_type{ Tetromino::Type::I },
+		_empty{ true },
+		_lock{ false }
+	{}
+
+	void HoldManager::hold(Tetromino::Type type)
+	{
+		if (_empty || !_lock)
+		{
+			_type = type;
+			_lock = !_empty;
+			_empty = false;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <deque>
+
+#include "tetromino.h"
+#include "randomizer.h"
+
+
+namespace core
+{
+	class TetrominoManager
+	{
+	public:
+		static constexpr int next_count = 5;
+		static constexpr int buffer_size = 64;
+
+	private:
+		AnyRandomizer _randomizer;
+		Tetromino::Type _buffer[buffer_size];
+		unsigned int _bufferSize;
+		unsigned int _bufferNext;
+		std::deque<Tetromino::Type> _next;
+
+	public:
+		TetrominoManager(UInt64 seed = 0, RandomizerType randomizer = RandomizerType::SevenBag);
+		TetrominoManager(const TetrominoManager&) = default;
+		TetrominoManager(TetrominoManager&&) noexcept = default;
+		~TetrominoManager() = default;
+
+		TetrominoManager& operator= (const TetrominoManager&) = default;
+		TetrominoManager& operator= (TetrominoManager&&) noexcept = default;
+
+		Tetromino next();
+
+		inline const std::deque<Tetromino::Type>& queue() const { return _next; }
+
+		/* Writes the next count types that will be dealt, the queue included, without taking them */
+		void upcoming(Tetromino::Type* types, Size count) const;
+
+		inline UInt64 seed() const { return _randomizer.seed(); }
+
+		inline RandomizerType randomizerType() const { return _randomizer.type(); }
+
+	private:
+		void generate();
+	};
+
+
+
+	class HoldManager
+	{
+	private:
+		Tetromino::Type _type;
+		bool _empty;
+		bool _lock;
+
+	public:
+		HoldManager();
+		HoldManager(const HoldManager&) = default;
+		HoldManager(HoldManager&&) noexcept = default;
+		~HoldManager() = default;
+
+		HoldManager& operator= (const HoldManager&) = default;
+		HoldManager& operator= (HoldManager&&) noexcept = default;
+
+		void hold(Tetromino::Type type);
+
+		inline bool empty() const { return _empty; }
+
+		inline void hold(const Tetromino& tetromino) { hold(tetromino.type()); }
+
+		inline Tetromino::Type type() const { return _type; }
+
+		inline bool isLock() const { return _lock; }
+
+		inline void unlock() { _lock = false; }
+	};
+}
@@ -0,0 +1,140 @@
+#include "thread_pool.h"
+
+
+namespace core
+{
+	WorkStealingPool::WorkStealingPool(unsigned int threads) :
+		_queues{},
+		_threads{},
+		_mutex{},
+		_wake{},
+		_done{},
+		_task{ nullptr },
+		_generation{ 0 },
+		_pending{ 0 },
+		_stop{ false }
+	{
+		threads = std::max(1U, threads);
+
+		_queues.reserve(threads);
+		for (unsigned int i = 0; i < threads; i++)
+			_queues.push_back(std::make_unique<Queue>());
+
+		_threads.reserve(threads - 1);
+		for (unsigned int i = 1; i < threads; i++)
+			_threads.emplace_back(&WorkStealingPool::_workerLoop, this, i);
+	}
+
+	WorkStealingPool::~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_stop = true;
+		}
+		_wake.notify_all();
+
+		for (auto& thread : _threads)
+			thread.join();
+	}
+
+	void WorkStealingPool::parallelFor(unsigned int count, const Task& task)
+	{
+		if (count == 0)
+			return;
+
+		if (_threads.empty())
+		{
+			for (unsigned int i = 0; i < count; i++)
+				task(i, 0);
+			return;
+		}
+
+		/* A few ranges per worker, so the ones that finish early have something to steal */
+		const unsigned int workers = size();
+		const unsigned int chunk = std::max(1U, count / (workers * 4));
+		const unsigned int chunks = (count + chunk - 1) / chunk;
+
+		_task = &task;
+		_pending.store(chunks);
+		for (unsigned int i = 0; i < chunks; i++)
+		{
+			Queue& queue = *_queues[i % workers];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			queue.ranges.push_back({ i * chunk, std::min(count, (i + 1) * chunk) });
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_generation++;
+		}
+		_wake.notify_all();
+
+		_drain(0);
+
+		std::unique_lock<std::mutex> lock{ _mutex };
+		_done.wait(lock, [this]() { return _pending.load() == 0; });
+		_task = nullptr;
+	}
+
+	void WorkStealingPool::_workerLoop(unsigned int worker)
+	{
+		UInt64 generation = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ _mutex };
+				_wake.wait(lock, [this, generation]() { return _stop || _generation != generation; });
+				if (_stop)
+					return;
+				generation = _generation;
+			}
+
+			_drain(worker);
+		}
+	}
+
+	void WorkStealingPool::_drain(unsigned int worker)
+	{
+		Range range;
+		while (_pop(worker, range) || _steal(worker, range))
+		{
+			for (unsigned int i = range.begin; i < range.end; i++)
+				(*_task)(i, worker);
+
+			if (_pending.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> lock{ _mutex };
+				_done.notify_all();
+			}
+		}
+	}
+
+	bool WorkStealingPool::_pop(unsigned int worker, Range& range)
+	{
+		Queue& queue = *_queues[worker];
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		if (queue.ranges.empty())
+			return false;
+
+		range = queue.ranges.back();
+		queue.ranges.pop_back();
+		return true;
+	}
+
+	bool WorkStealingPool::_steal(unsigned int worker, Range& range)
+	{
+		const unsigned int workers = size();
+		for (unsigned int i = 1; i < workers; i++)
+		{
+			Queue& queue = *_queues[(worker + i) % workers];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (queue.ranges.empty())
+				continue;
+
+			range = queue.ranges.front();
+			queue.ranges.pop_front();
+			return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "basics.h"
+
+
+namespace core
+{
+	/*
+	 * Fixed set of workers, each one with its own deque of index ranges. Workers take their
+	 * own work from the back and steal from the front of the others when they run out.
+	 * The calling thread works as worker 0, so a pool of one thread runs everything inline.
+	 */
+	class WorkStealingPool
+	{
+	public:
+		typedef std::function<void(unsigned int index, unsigned int worker)> Task;
+
+	private:
+		struct Range
+		{
+			unsigned int begin;
+			unsigned int end;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Range> ranges;
+		};
+
+	private:
+		std::vector<std::unique_ptr<Queue>> _queues;
+		std::vector<std::thread> _threads;
+
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::condition_variable _done;
+
+		const Task* _task;
+		UInt64 _generation;
+		std::atomic<unsigned int> _pending;
+		bool _stop;
+
+	public:
+		explicit WorkStealingPool(unsigned int threads = std::thread::hardware_concurrency());
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool(WorkStealingPool&&) noexcept = delete;
+		~WorkStealingPool();
+
+		WorkStealingPool& operator= (const WorkStealingPool&) = delete;
+		WorkStealingPool& operator= (WorkStealingPool&&) noexcept = delete;
+
+		/* Runs task for every index in [0, count) and waits until all of them are done */
+		void parallelFor(unsigned int count, const Task& task);
+
+		inline unsigned int size() const { return static_cast<unsigned int>(_queues.size()); }
+
+	private:
+		void _workerLoop(unsigned int worker);
+
+		void _drain(unsigned int worker);
+
+		bool _pop(unsigned int worker, Range& range);
+		bool _steal(unsigned int worker, Range& range);
+	};
+}
@@ -0,0 +1,143 @@
+#include "trace.h"
+
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+
+namespace core::trace
+{
+	namespace
+	{
+		std::mutex registry_mutex;
+		std::deque<std::unique_ptr<ThreadBuffer>> registry;
+
+		void write_string(std::ostream& os, const char* text)
+		{
+			os << '"';
+			for (; *text; text++)
+			{
+				if (*text == '"' || *text == '\\')
+					os << '\\';
+				os << *text;
+			}
+			os << '"';
+		}
+
+		void write_time(std::ostream& os, Int64 nanoseconds)
+		{
+			/* Chrome trace times are microseconds, the fraction keeps the nanoseconds */
+			os << (nanoseconds / 1000) << '.' << static_cast<char>('0' + ((nanoseconds / 100) % 10))
+				<< static_cast<char>('0' + ((nanoseconds / 10) % 10)) << static_cast<char>('0' + (nanoseconds % 10));
+		}
+	}
+
+
+
+	ThreadBuffer::ThreadBuffer(UInt32 id) :
+		_slots{ new Slot[capacity] },
+		_head{ 0 },
+		_reserved{ 0 },
+		_id{ id },
+		_name{}
+	{}
+
+	void ThreadBuffer::write(std::ostream& os, bool& first) const
+	{
+		struct Entry
+		{
+			const char* name;
+			Int64 start;
+			Int64 end;
+		};
+
+		const UInt64 head = _head.load(std::memory_order_acquire);
+		const UInt64 begin = head > capacity ? head - capacity : 0;
+
+		std::vector<Entry> entries;
+		entries.reserve(static_cast<Size>(head - begin));
+		for (UInt64 i = begin; i < head; i++)
+		{
+			const Slot& slot = _slots[i & (capacity - 1)];
+			entries.push_back({ slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed) });
+		}
+
+		/* Slots the owner reused during the copy hold newer zones mixed with older ones */
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const UInt64 reserved = _reserved.load(std::memory_order_relaxed);
+		const UInt64 valid = reserved > capacity ? reserved - capacity : 0;
+
+		for (UInt64 i = std::max(begin, valid); i < head; i++)
+		{
+			const Entry& entry = entries[static_cast<Size>(i - begin)];
+			os << (first ? "\n" : ",\n") << "{\"name\":";
+			write_string(os, entry.name);
+			os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << _id << ",\"ts\":";
+			write_time(os, entry.start);
+			os << ",\"dur\":";
+			write_time(os, entry.end - entry.start);
+			os << '}';
+			first = false;
+		}
+	}
+
+
+
+	Int64 now()
+	{
+		static const auto epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	ThreadBuffer& threadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (!buffer)
+		{
+			/* Buffers outlive their threads, so zones of finished threads are still dumped */
+			std::lock_guard<std::mutex> lock{ registry_mutex };
+			registry.push_back(std::make_unique<ThreadBuffer>(static_cast<UInt32>(registry.size() + 1)));
+			buffer = registry.back().get();
+		}
+		return *buffer;
+	}
+
+	void threadName(const char* name)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+
+		std::lock_guard<std::mutex> lock{ registry_mutex };
+		buffer._name = name;
+	}
+
+	void dump(std::ostream& os)
+	{
+		std::lock_guard<std::mutex> lock{ registry_mutex };
+
+		bool first = true;
+		os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		for (const auto& buffer : registry)
+		{
+			if (!buffer->name().empty())
+			{
+				os << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id() << ",\"args\":{\"name\":";
+				write_string(os, buffer->name().c_str());
+				os << "}}";
+				first = false;
+			}
+			buffer->write(os, first);
+		}
+		os << "\n]}\n";
+	}
+
+	bool dump(const std::string& filename)
+	{
+		std::ofstream file{ filename, std::ios::out | std::ios::trunc };
+		if (!file)
+			return false;
+
+		dump(file);
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "basics.h"
+
+
+/*
+ * Zone timers for hot paths. CORE_TRACE_ZONE("name") records the time until the end of the scope.
+ * Zones are only compiled with TETRIS_TRACE defined. Without it the macros expand to nothing,
+ * so instrumented code is the same as code without them.
+ */
+#ifdef TETRIS_TRACE
+#define CORE_TRACE_JOIN_(left, right) left##right
+#define CORE_TRACE_JOIN(left, right) CORE_TRACE_JOIN_(left, right)
+#define CORE_TRACE_ZONE(name) const ::core::trace::Zone CORE_TRACE_JOIN(_traceZone, __LINE__){ name }
+#define CORE_TRACE_THREAD(name) ::core::trace::threadName(name)
+#else
+#define CORE_TRACE_ZONE(name) ((void)0)
+#define CORE_TRACE_THREAD(name) ((void)0)
+#endif
+
+
+namespace core::trace
+{
+	/*
+	 * Ring of the last zones closed by one thread. Only that thread writes, so recording never
+	 * locks. Like a seqlock, the writer announces the slot it is about to reuse before touching
+	 * it, and readers drop whatever the writer reached while they were copying.
+	 */
+	class ThreadBuffer
+	{
+	public:
+		static constexpr Size capacity = 1 << 16;
+
+	private:
+		struct Slot
+		{
+			std::atomic<const char*> name;
+			std::atomic<Int64> start;
+			std::atomic<Int64> end;
+		};
+
+	private:
+		std::unique_ptr<Slot[]> _slots;
+		std::atomic<UInt64> _head;
+		std::atomic<UInt64> _reserved;
+		UInt32 _id;
+		std::string _name;
+
+	public:
+		explicit ThreadBuffer(UInt32 id);
+		ThreadBuffer(const ThreadBuffer&) = delete;
+		ThreadBuffer(ThreadBuffer&&) noexcept = delete;
+		~ThreadBuffer() = default;
+
+		ThreadBuffer& operator= (const ThreadBuffer&) = delete;
+		ThreadBuffer& operator= (ThreadBuffer&&) noexcept = delete;
+
+		inline void record(const char* name, Int64 start, Int64 end)
+		{
+			const UInt64 head = _head.load(std::memory_order_relaxed);
+			_reserved.store(head + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			Slot& slot = _slots[head & (capacity - 1)];
+			slot.name.store(name, std::memory_order_relaxed);
+			slot.start.store(start, std::memory_order_relaxed);
+			slot.end.store(end, std::memory_order_relaxed);
+			_head.store(head + 1, std::memory_order_release);
+		}
+
+		/* Writes the recorded zones as Chrome trace events, each one preceded by a comma when first is false */
+		void write(std::ostream& os, bool& first) const;
+
+		inline UInt32 id() const { return _id; }
+		inline const std::string& name() const { return _name; }
+
+		friend void threadName(const char* name);
+	};
+
+	/* Nanoseconds since the first call, from a steady clock */
+	Int64 now();
+
+	/* Buffer of the calling thread, registered on its first use */
+	ThreadBuffer& threadBuffer();
+
+	/* Name shown for the calling thread in trace viewers */
+	void threadName(const char* name);
+
+	/* Every zone still in the buffers, as Chrome trace event JSON (chrome://tracing, Perfetto) */
+	void dump(std::ostream& os);
+	bool dump(const std::string& filename);
+
+	class Zone
+	{
+	private:
+		const char* _name;
+		Int64 _start;
+
+	public:
+		explicit inline Zone(const char* name) : _name{ name }, _start{ now() } {}
+		Zone(const Zone&) = delete;
+		Zone(Zone&&) noexcept = delete;
+		inline ~Zone() { threadBuffer().record(_name, _start, now()); }
+
+		Zone& operator= (const Zone&) = delete;
+		Zone& operator= (Zone&&) noexcept = delete;
+	};
+}
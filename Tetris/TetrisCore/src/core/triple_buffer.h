@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+
+#include "basics.h"
+
+
+namespace core
+{
+	/*
+	 * Single producer, single consumer hand-off of whole values without locks. The writer fills
+	 * back() and publishes it; the reader fetches the latest published value into front(). Each
+	 * side owns one slot and the third one is swapped between them through one atomic byte, so
+	 * neither side ever waits and the reader never sees a half written value.
+	 */
+	template<typename _Ty>
+	class TripleBuffer
+	{
+	private:
+		static constexpr UInt8 index_mask = 0x3;
+		static constexpr UInt8 fresh_bit = 0x4;
+
+	private:
+		struct alignas(64) Slot { _Ty value; };
+
+		Slot _slots[3];
+		UInt8 _back;
+		alignas(64) std::atomic<UInt8> _middle;
+		alignas(64) UInt8 _front;
+
+	public:
+		TripleBuffer() : _slots{}, _back{ 0 }, _middle{ 1 }, _front{ 2 } {}
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer(TripleBuffer&&) noexcept = delete;
+		~TripleBuffer() = default;
+
+		TripleBuffer& operator= (const TripleBuffer&) = delete;
+		TripleBuffer& operator= (TripleBuffer&&) noexcept = delete;
+
+		/* Writer side. The slot may hold any older value, so it has to be written entirely */
+		inline _Ty& back() { return _slots[_back].value; }
+
+		inline void publish() { _back = _middle.exchange(static_cast<UInt8>(_back | fresh_bit), std::memory_order_acq_rel) & index_mask; }
+
+		/* Reader side. Returns false, keeping the current front, when nothing was published since the last fetch */
+		inline bool fetch()
+		{
+			if (!(_middle.load(std::memory_order_relaxed) & fresh_bit))
+				return false;
+
+			_front = _middle.exchange(_front, std::memory_order_acq_rel) & index_mask;
+			return true;
+		}
+
+		inline const _Ty& front() const { return _slots[_front].value; }
+	};
+}